@@ -0,0 +1,192 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cxxopts.hpp>
+#include <fmt/format.h>
+
+namespace
+{
+struct toolchain
+{
+    std::string m_cxx;
+    std::string m_flags;
+    std::vector<std::string> m_includes;
+    std::vector<std::string> m_libs;
+    bool m_msvc{false};
+};
+
+std::string quote(const std::string &s) { return "\"" + s + "\""; }
+
+/// Write a suite of generated TEST_CASEs, as a ReqIF generated suite might look.
+void generate(const std::filesystem::path &src, std::size_t cases, std::size_t asserts)
+{
+    std::ofstream os(src);
+    os << "#include \"cat/cat.h\"\n\n";
+    for(std::size_t u = 0U; u != cases; ++u)
+    {
+        os << "TEST_CASE(Generated" << u << ")\n{\n";
+        os << "    const int i = " << u << ";\n";
+        os << "    const double x = " << u << " * 0.5;\n";
+        for(std::size_t a = 0U; a != asserts; ++a)
+        {
+            switch(a % 4U)
+            {
+            case 0U:
+                os << "    test(CAT_ASSERT(i + " << a << " >= i));\n";
+                break;
+            case 1U:
+                os << "    test(CAT_ASSERT(x <= " << u + a << ".0));\n";
+                break;
+            case 2U:
+                os << "    test(CAT_ASSERT(i == " << u << "));\n";
+                break;
+            default:
+                os << "    test(CAT_ASSERT(x != -1.0));\n";
+                break;
+            }
+        }
+        os << "}\n\n";
+    }
+    os << "int main()\n{\n"
+          "    cat::test_runner runner;\n"
+          "    runner.run(cat::registry::get_instance().get_test_series_all());\n"
+          "}\n";
+    if(!os)
+        throw std::runtime_error("Failed to write " + src.string());
+}
+
+/// Run the command and return how long it took, in seconds.
+double timed(const std::string &command)
+{
+    const auto start = std::chrono::steady_clock::now();
+    if(std::system(command.c_str()) != 0)
+        throw std::runtime_error("Command failed: " + command);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::string compile_command(
+    const toolchain &tc,
+    const std::filesystem::path &src,
+    const std::filesystem::path &obj)
+{
+    std::string cmd = quote(tc.m_cxx);
+    cmd += tc.m_msvc ? " /nologo /std:c++20 /EHsc /utf-8 " : " -std=c++20 ";
+    cmd += tc.m_flags;
+    for(auto &inc : tc.m_includes)
+        cmd += (tc.m_msvc ? " /I" : " -I") + quote(inc);
+    cmd += tc.m_msvc ? " /c " + quote(src.string()) + " /Fo" + quote(obj.string())
+                     : " -c " + quote(src.string()) + " -o " + quote(obj.string());
+    return cmd;
+}
+
+std::string link_command(
+    const toolchain &tc,
+    const std::filesystem::path &obj,
+    const std::filesystem::path &exe)
+{
+    std::string cmd = quote(tc.m_cxx) + (tc.m_msvc ? " /nologo " : " ") + quote(obj.string());
+    for(auto &lib : tc.m_libs)
+        cmd += " " + quote(lib);
+    cmd += tc.m_msvc ? " /Fe" + quote(exe.string()) : " -o " + quote(exe.string());
+    return cmd;
+}
+}
+
+int main(int argc, char **argv)
+{
+    cxxopts::Options options(
+        "build_benchmark",
+        "Measure the compile time, link time and size of generated TEST_CASE suites");
+    // clang-format off
+    options.add_options()
+        ("cxx", "C++ compiler", cxxopts::value<std::string>())
+        ("msvc", "The compiler takes MSVC style options")
+        ("flags", "Extra compile flags, e.g. -O2", cxxopts::value<std::string>()->default_value(""))
+        ("include", "Include directory", cxxopts::value<std::vector<std::string>>())
+        ("lib", "Library or flag to link", cxxopts::value<std::vector<std::string>>())
+        ("cases", "Suite sizes to measure",
+            cxxopts::value<std::vector<std::size_t>>()->default_value("100,1000,10000"))
+        ("asserts", "CAT_ASSERTs per test case", cxxopts::value<std::size_t>()->default_value("4"))
+        ("dir", "Directory for the generated files",
+            cxxopts::value<std::string>()->default_value("build_benchmark"))
+        ("h,help", "Print usage");
+    // clang-format on
+    auto args = options.parse(argc, argv);
+
+    if(args.count("help") || !args.count("cxx"))
+    {
+        std::cout << options.help() << "\n";
+        return args.count("help") ? 0 : 1;
+    }
+
+    toolchain tc;
+    tc.m_cxx = args["cxx"].as<std::string>();
+    tc.m_msvc = args.count("msvc") != 0U;
+    tc.m_flags = args["flags"].as<std::string>();
+    // Skip empty values, e.g. from a generator expression expanding to nothing:
+    auto values = [&](const std::string &key)
+    {
+        std::vector<std::string> v;
+        if(args.count(key))
+            for(auto &s : args[key].as<std::vector<std::string>>())
+                if(!s.empty())
+                    v.push_back(s);
+        return v;
+    };
+    tc.m_includes = values("include");
+    tc.m_libs = values("lib");
+
+    const std::filesystem::path dir = args["dir"].as<std::string>();
+    std::filesystem::create_directories(dir);
+
+    fmt::print(
+        "{:>8} {:>12} {:>10} {:>14} {:>14}\n",
+        "cases",
+        "compile [s]",
+        "link [s]",
+        "object [kB]",
+        "binary [kB]");
+    for(auto cases : args["cases"].as<std::vector<std::size_t>>())
+    {
+        const auto stem = dir / fmt::format("suite_{}", cases);
+        const auto src = stem.string() + ".cpp";
+        const auto obj = stem.string() + (tc.m_msvc ? ".obj" : ".o");
+        const auto exe = stem.string() + (tc.m_msvc ? ".exe" : "");
+
+        generate(src, cases, args["asserts"].as<std::size_t>());
+        const double compile_s = timed(compile_command(tc, src, obj));
+        const double link_s = timed(link_command(tc, obj, exe));
+
+        fmt::print(
+            "{:>8} {:>12.2f} {:>10.2f} {:>14} {:>14}\n",
+            cases,
+            compile_s,
+            link_s,
+            std::filesystem::file_size(obj) / 1024U,
+            std::filesystem::file_size(exe) / 1024U);
+    }
+    return 0;
+}
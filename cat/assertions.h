@@ -16,6 +16,10 @@
  * limitations under the License.
  *****************************************************************************/
 #pragma once
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
 
 namespace cat
 {
@@ -40,63 +44,102 @@ struct assertion
     bool m_result{false};
     std::string m_lhs;
     std::string m_rhs;
+    const char *m_file{nullptr}; //!< Assertion site
+    int m_line{0};
+    std::optional<double> m_lhs_value; //!< Measured value, if the LHS is arithmetic
+    std::optional<double> m_rhs_value; //!< Limit, if the RHS is arithmetic
 
     bool get_result() const { return m_result; }
 };
 
+/// Where and what was asserted.
+struct assertion_site
+{
+    const char *m_expr;
+    const char *m_file;
+    int m_line;
+};
+
+/// The result of CAT_ASSERT. Trivially destructible, so that each CAT_ASSERT expands to little
+/// code; test_case::test expands it into an assertion for the reporters.
+struct assertion_result
+{
+    assertion_site m_site;
+    op m_op;
+    bool m_result;
+    std::optional<double> m_lhs_value;
+    std::optional<double> m_rhs_value;
+
+    bool get_result() const { return m_result; }
+};
+
+/// The measured value / limit of an operand, if it is arithmetic.
+template <class T>
+std::optional<double> operand_value(const T &v)
+{
+    if constexpr(std::is_arithmetic_v<T>)
+        return static_cast<double>(v);
+    else
+        return std::nullopt;
+}
+
+/// Arithmetic operands are captured by value, so that e.g. int, int & and const int & share one
+/// assertion_builder.
+template <class T>
+using operand_t = std::conditional_t<std::is_arithmetic_v<std::decay_t<T>>, std::decay_t<T>, T>;
+
 template <class LHS>
 struct assertion_builder
 {
-    LHS m_lhs;              //!< The left hand side gets captured
-    assertion &m_assertion; //!< Build the assert data here
+    assertion_site m_site;
+    LHS m_lhs; //!< The left hand side gets captured
 
     // clang-format off
     template <class RHS>
-    assertion operator==(RHS &&rhs) && { return set(op::eq, m_lhs == rhs); }
+    assertion_result operator==(RHS &&rhs) && { return set(op::eq, m_lhs == rhs, rhs); }
 
     template <class RHS>
-    assertion operator!=(RHS &&rhs) && { return set(op::neq, m_lhs != rhs); }
+    assertion_result operator!=(RHS &&rhs) && { return set(op::neq, m_lhs != rhs, rhs); }
 
     template <class RHS>
-    assertion operator<(RHS &&rhs) && { return set(op::l, m_lhs < rhs); }
+    assertion_result operator<(RHS &&rhs) && { return set(op::l, m_lhs < rhs, rhs); }
 
     template <class RHS>
-    assertion operator<=(RHS &&rhs) && { return set(op::le, m_lhs <= rhs); }
+    assertion_result operator<=(RHS &&rhs) && { return set(op::le, m_lhs <= rhs, rhs); }
 
     template <class RHS>
-    assertion operator>(RHS &&rhs) && { return set(op::g, m_lhs > rhs); }
+    assertion_result operator>(RHS &&rhs) && { return set(op::g, m_lhs > rhs, rhs); }
 
     template <class RHS>
-    assertion operator>=(RHS &&rhs) { return set(op::ge, m_lhs >= rhs); }
+    assertion_result operator>=(RHS &&rhs) { return set(op::ge, m_lhs >= rhs, rhs); }
 
     template <class RHS>
-    assertion operator&&(RHS &&rhs) && { return set(op::logical_and, m_lhs && rhs); }
+    assertion_result operator&&(RHS &&rhs) && { return set(op::logical_and, m_lhs && rhs, rhs); }
 
     // clang-format on
 
-    assertion &&set(op the_op, bool result)
+    template <class RHS>
+    assertion_result set(op the_op, bool result, const RHS &rhs)
     {
-        m_assertion.m_op = the_op;
-        m_assertion.m_result = result;
-        return std::move(m_assertion);
+        return assertion_result{m_site, the_op, result, operand_value(m_lhs), operand_value(rhs)};
     }
 };
 
 struct decompose_helper
 {
-    assertion m_assertion;
+    assertion_site m_site;
 
     template <class LHS>
-    assertion_builder<LHS> operator<(LHS &&lhs) &&
+    assertion_builder<operand_t<LHS>> operator<(LHS &&lhs) &&
     {
-        return assertion_builder<LHS>{std::forward<LHS>(lhs), m_assertion};
+        return assertion_builder<operand_t<LHS>>{m_site, std::forward<LHS>(lhs)};
     }
 };
 
 /// Decompose the binary comparison expression using the operator precedence of <.
 /// See https://fekir.info/post/decomposing-an-expression/
 #define DECOMPOSE_BINARY_OP(expr)                                                                  \
-    cat::decompose_helper{cat::assertion{#expr, cat::op::none, false}} < expr
+    cat::decompose_helper{cat::assertion_site{#expr, __FILE__, __LINE__}} < expr
 
 #define CAT_ASSERT(expr) DECOMPOSE_BINARY_OP(expr)
 }
\ No newline at end of file
@@ -0,0 +1,243 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include <algorithm>
+
+#include "async.h"
+
+namespace cat
+{
+namespace
+{
+thread_local scheduler *current_scheduler = nullptr;
+
+/// Reschedule the awaiting coroutine onto the scheduler's ready queue.
+struct schedule_on
+{
+    scheduler &m_scheduler;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) const { m_scheduler.post(h); }
+    void await_resume() const noexcept { }
+};
+}
+
+scheduler *scheduler::current() { return current_scheduler; }
+
+scheduler::scheduler(std::size_t blocking_threads) :
+    m_blocking_threads_max(std::max<std::size_t>(blocking_threads, 1U))
+{
+}
+
+scheduler::~scheduler()
+{
+    {
+        std::lock_guard lock(m_blocking_mutex);
+        m_stopping = true;
+        m_blocking_cv.notify_all();
+    }
+    for(auto &t : m_blocking_threads)
+        t.join();
+
+    // A queued coroutine owns the task it runs, which is destroyed along with it:
+    for(auto h : m_ready)
+        h.destroy();
+    for(; !m_timers.empty(); m_timers.pop())
+        m_timers.top().m_handle.destroy();
+}
+
+void scheduler::spawn(task t)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        ++m_in_flight;
+    }
+    launch(std::move(t));
+}
+
+scheduler::detached scheduler::launch(task t)
+{
+    co_await schedule_on{*this};
+
+    std::exception_ptr e;
+    try
+    {
+        co_await t;
+    }
+    catch(...)
+    {
+        e = std::current_exception();
+    }
+    finished(std::move(e));
+}
+
+void scheduler::finished(std::exception_ptr e)
+{
+    std::lock_guard lock(m_mutex);
+    if(e && !m_exception)
+        m_exception = std::move(e);
+    if(--m_in_flight == 0)
+        m_cv.notify_all();
+}
+
+// Notify while holding the lock: once it is released, the posted coroutine may complete the
+// last task and run() may return (destroying the scheduler) before a late notify.
+void scheduler::post(std::coroutine_handle<> h)
+{
+    std::lock_guard lock(m_mutex);
+    m_ready.push_back(h);
+    m_cv.notify_one();
+}
+
+void scheduler::post_at(clock::time_point t, std::coroutine_handle<> h)
+{
+    std::lock_guard lock(m_mutex);
+    m_timers.push(timer{t, h});
+    // Wake everyone: a sleeping thread may be waiting on a later timer.
+    m_cv.notify_all();
+}
+
+void scheduler::run_blocking(std::function<void()> f)
+{
+    std::lock_guard lock(m_blocking_mutex);
+    m_blocking_calls.push_back(std::move(f));
+    if(m_blocking_idle == 0U && m_blocking_threads.size() < m_blocking_threads_max)
+        m_blocking_threads.emplace_back([this] { blocking_worker(); });
+    else
+        m_blocking_cv.notify_one();
+}
+
+void scheduler::blocking_worker()
+{
+    std::unique_lock lock(m_blocking_mutex);
+    while(true)
+    {
+        if(!m_blocking_calls.empty())
+        {
+            auto f = std::move(m_blocking_calls.front());
+            m_blocking_calls.pop_front();
+            lock.unlock();
+            f();
+            lock.lock();
+            continue;
+        }
+
+        // The calls still queued are run before stopping, as coroutines may be waiting on them.
+        if(m_stopping)
+            break;
+
+        ++m_blocking_idle;
+        m_blocking_cv.wait(lock);
+        --m_blocking_idle;
+    }
+}
+
+void scheduler::run(std::size_t threads)
+{
+    std::vector<std::thread> pool;
+    for(std::size_t u = 1U; u < threads; ++u)
+        pool.emplace_back([this] { worker(); });
+
+    worker();
+
+    for(auto &t : pool)
+        t.join();
+
+    std::exception_ptr e;
+    {
+        std::lock_guard lock(m_mutex);
+        e = std::exchange(m_exception, nullptr);
+    }
+    if(e)
+        std::rethrow_exception(e);
+}
+
+void scheduler::worker()
+{
+    auto previous = std::exchange(current_scheduler, this);
+
+    std::unique_lock lock(m_mutex);
+    while(true)
+    {
+        const auto now = clock::now();
+        while(!m_timers.empty() && m_timers.top().m_when <= now)
+        {
+            m_ready.push_back(m_timers.top().m_handle);
+            m_timers.pop();
+        }
+
+        if(!m_ready.empty())
+        {
+            auto h = m_ready.front();
+            m_ready.pop_front();
+            lock.unlock();
+            h.resume();
+            lock.lock();
+            continue;
+        }
+
+        if(m_in_flight == 0)
+            break;
+
+        if(m_timers.empty())
+            m_cv.wait(lock);
+        else
+        {
+            const auto when = m_timers.top().m_when;
+            m_cv.wait_until(lock, when);
+        }
+    }
+    lock.unlock();
+    m_cv.notify_all();
+
+    current_scheduler = previous;
+}
+
+bool async_mutex::lock_awaiter::await_suspend(std::coroutine_handle<> h)
+{
+    auto s = scheduler::current();
+    if(!s)
+        throw std::runtime_error("cat::async_mutex locked outside of a scheduler");
+
+    std::lock_guard lock(m_mutex.m_mutex);
+    if(!m_mutex.m_locked)
+    {
+        m_mutex.m_locked = true;
+        return false;
+    }
+    m_mutex.m_waiters.push_back(waiter{h, s});
+    return true;
+}
+
+void async_mutex::unlock()
+{
+    waiter next{};
+    {
+        std::lock_guard lock(m_mutex);
+        if(m_waiters.empty())
+        {
+            m_locked = false;
+            return;
+        }
+        // The mutex stays locked, on behalf of the next waiter:
+        next = m_waiters.front();
+        m_waiters.pop_front();
+    }
+    next.m_scheduler->post(next.m_handle);
+}
+}
\ No newline at end of file
@@ -0,0 +1,368 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace cat
+{
+
+/// Lazily started coroutine returning void. Awaiting a task starts it and resumes the awaiter
+/// when it completes, rethrowing any exception that escaped the task body.
+class task
+{
+public:
+    struct promise_type
+    {
+        std::coroutine_handle<> m_continuation;
+        std::exception_ptr m_exception;
+
+        struct final_awaiter
+        {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<>
+            await_suspend(std::coroutine_handle<promise_type> h) noexcept
+            {
+                auto c = h.promise().m_continuation;
+                return c ? c : std::noop_coroutine();
+            }
+            void await_resume() noexcept { }
+        };
+
+        task get_return_object()
+        {
+            return task{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        final_awaiter final_suspend() noexcept { return {}; }
+        void return_void() { }
+        void unhandled_exception() { m_exception = std::current_exception(); }
+    };
+
+    task(task &&other) noexcept : m_handle(std::exchange(other.m_handle, {})) { }
+    task &operator=(task &&other) noexcept
+    {
+        if(this != &other)
+        {
+            if(m_handle)
+                m_handle.destroy();
+            m_handle = std::exchange(other.m_handle, {});
+        }
+        return *this;
+    }
+    task(const task &) = delete;
+    task &operator=(const task &) = delete;
+    ~task()
+    {
+        if(m_handle)
+            m_handle.destroy();
+    }
+
+    bool await_ready() const noexcept { return !m_handle || m_handle.done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept
+    {
+        m_handle.promise().m_continuation = continuation;
+        return m_handle;
+    }
+    void await_resume()
+    {
+        if(m_handle && m_handle.promise().m_exception)
+            std::rethrow_exception(m_handle.promise().m_exception);
+    }
+
+private:
+    explicit task(std::coroutine_handle<promise_type> h) : m_handle(h) { }
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+/// Event loop which interleaves many in-flight tasks on a small number of threads. Suspended
+/// coroutines are resumed from either the ready queue or the timer queue; run() returns once
+/// every spawned task has completed.
+class scheduler
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    static constexpr std::size_t default_blocking_threads = 4U;
+
+    /// \param blocking_threads Maximum number of threads running offloaded blocking calls
+    explicit scheduler(std::size_t blocking_threads = default_blocking_threads);
+    /// Waits for the offloaded blocking calls still running, then destroys the coroutines still
+    /// queued, e.g. tasks spawned but never run.
+    ~scheduler();
+    scheduler(const scheduler &) = delete;
+    scheduler &operator=(const scheduler &) = delete;
+
+    /// Start the task when the scheduler runs. Exceptions escaping the task are rethrown from
+    /// run() (the first one wins).
+    void spawn(task t);
+
+    /// Resume the coroutine on one of the scheduler threads. Safe to call from any thread.
+    void post(std::coroutine_handle<> h);
+
+    /// Resume the coroutine once the time point has been reached.
+    void post_at(clock::time_point t, std::coroutine_handle<> h);
+
+    /// Run the event loop on the calling thread plus threads - 1 additional threads.
+    void run(std::size_t threads = 1);
+
+    /// Run a blocking call on one of at most blocking_threads threads, which are started on
+    /// demand and joined when the scheduler is destroyed. Safe to call from any thread.
+    void run_blocking(std::function<void()> f);
+
+    /// The scheduler driving the calling thread, or nullptr outside of run().
+    static scheduler *current();
+
+private:
+    struct detached
+    {
+        struct promise_type
+        {
+            detached get_return_object() { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() { }
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+
+    struct timer
+    {
+        clock::time_point m_when;
+        std::coroutine_handle<> m_handle;
+        bool operator>(const timer &other) const { return m_when > other.m_when; }
+    };
+
+    detached launch(task t);
+    void worker();
+    void blocking_worker();
+    void finished(std::exception_ptr e);
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<std::coroutine_handle<>> m_ready;
+    std::priority_queue<timer, std::vector<timer>, std::greater<timer>> m_timers;
+    std::size_t m_in_flight{0};
+    std::exception_ptr m_exception;
+
+    // Offloaded blocking calls, kept apart so that they never hold an event loop thread:
+    std::mutex m_blocking_mutex;
+    std::condition_variable m_blocking_cv;
+    std::deque<std::function<void()>> m_blocking_calls;
+    std::vector<std::thread> m_blocking_threads;
+    std::size_t m_blocking_threads_max;
+    std::size_t m_blocking_idle{0};
+    bool m_stopping{false};
+};
+
+/// Mutual exclusion between coroutines. A coroutine waiting for the lock is suspended instead of
+/// blocking its scheduler thread, and waiters are handed the lock in the order they arrived.
+class async_mutex
+{
+public:
+    struct lock_awaiter
+    {
+        async_mutex &m_mutex;
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> h);
+        void await_resume() const noexcept { }
+    };
+
+    /// co_await lock() to acquire the mutex.
+    lock_awaiter lock() { return lock_awaiter{*this}; }
+
+    /// Release the mutex, handing it to the coroutine which has waited longest (if any).
+    void unlock();
+
+private:
+    struct waiter
+    {
+        std::coroutine_handle<> m_handle;
+        scheduler *m_scheduler;
+    };
+
+    std::mutex m_mutex;
+    bool m_locked{false};
+    std::deque<waiter> m_waiters;
+};
+
+/// Suspend the calling coroutine for the given duration without blocking the scheduler thread.
+struct delay
+{
+    scheduler::clock::duration m_duration;
+
+    template <class Rep, class Period>
+    explicit delay(std::chrono::duration<Rep, Period> d) :
+        m_duration(std::chrono::duration_cast<scheduler::clock::duration>(d))
+    {
+    }
+
+    bool await_ready() const noexcept { return m_duration <= scheduler::clock::duration::zero(); }
+    void await_suspend(std::coroutine_handle<> h) const
+    {
+        auto s = scheduler::current();
+        if(!s)
+            throw std::runtime_error("cat::delay awaited outside of a scheduler");
+        s->post_at(scheduler::clock::now() + m_duration, h);
+    }
+    void await_resume() const noexcept { }
+};
+
+/// One-shot result which a coroutine can co_await, e.g. an instrument reading delivered by a
+/// driver callback. set_value / set_exception may be called from any thread; the awaiting
+/// coroutine is resumed on its scheduler. completion<void> only signals, e.g. that a relay has
+/// switched, and is completed with set_value().
+template <class T>
+class completion
+{
+    using value_type = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+    struct state
+    {
+        std::mutex m_mutex;
+        bool m_done{false};
+        std::optional<value_type> m_value;
+        std::exception_ptr m_exception;
+        std::coroutine_handle<> m_waiter;
+        scheduler *m_scheduler{nullptr};
+    };
+
+public:
+    completion() : m_state(std::make_shared<state>()) { }
+
+    void set_value()
+        requires std::is_void_v<T>
+    {
+        complete(std::monostate{}, nullptr);
+    }
+    void set_value(value_type value)
+        requires(!std::is_void_v<T>)
+    {
+        complete(std::move(value), nullptr);
+    }
+    void set_exception(std::exception_ptr e) { complete(std::nullopt, std::move(e)); }
+
+    struct awaiter
+    {
+        std::shared_ptr<state> m_state;
+
+        bool await_ready() const
+        {
+            std::lock_guard lock(m_state->m_mutex);
+            return m_state->m_done;
+        }
+        bool await_suspend(std::coroutine_handle<> h)
+        {
+            auto s = scheduler::current();
+            if(!s)
+                throw std::runtime_error("cat::completion awaited outside of a scheduler");
+
+            // The coroutine may be resumed on another thread as soon as the lock is released,
+            // so only touch the (locally owned) shared state from here on.
+            auto st = m_state;
+            std::lock_guard lock(st->m_mutex);
+            if(st->m_done)
+                return false;
+            st->m_waiter = h;
+            st->m_scheduler = s;
+            return true;
+        }
+        T await_resume()
+        {
+            if(m_state->m_exception)
+                std::rethrow_exception(m_state->m_exception);
+            if constexpr(!std::is_void_v<T>)
+                return std::move(*m_state->m_value);
+        }
+    };
+
+    awaiter operator co_await() const { return awaiter{m_state}; }
+
+private:
+    void complete(std::optional<value_type> value, std::exception_ptr e)
+    {
+        std::coroutine_handle<> waiter;
+        scheduler *s = nullptr;
+        {
+            std::lock_guard lock(m_state->m_mutex);
+            if(m_state->m_done)
+                throw std::logic_error("cat::completion already completed");
+            m_state->m_value = std::move(value);
+            m_state->m_exception = std::move(e);
+            m_state->m_done = true;
+            waiter = std::exchange(m_state->m_waiter, {});
+            s = m_state->m_scheduler;
+        }
+        if(waiter)
+            s->post(waiter);
+    }
+
+    std::shared_ptr<state> m_state;
+};
+
+/// Run a blocking call (e.g. a synchronous instrument driver) on the blocking threads of the
+/// current scheduler and co_await the result. Prefer completing a cat::completion from the
+/// driver's callback where one exists.
+template <class F>
+completion<std::invoke_result_t<F>> offload(F f)
+{
+    using result_type = std::invoke_result_t<F>;
+
+    auto s = scheduler::current();
+    if(!s)
+        throw std::runtime_error("cat::offload called outside of a scheduler");
+
+    completion<result_type> c;
+    // std::function needs a copyable target, so share the (possibly move-only) callable:
+    s->run_blocking(
+        [c, f = std::make_shared<F>(std::move(f))]() mutable
+        {
+            try
+            {
+                if constexpr(std::is_void_v<result_type>)
+                {
+                    (*f)();
+                    c.set_value();
+                }
+                else
+                    c.set_value((*f)());
+            }
+            catch(...)
+            {
+                c.set_exception(std::current_exception());
+            }
+        });
+    return c;
+}
+}
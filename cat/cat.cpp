@@ -16,10 +16,160 @@
  * limitations under the License.
  *****************************************************************************/
 
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+
 #include "cat.h"
 
 namespace cat
 {
+namespace
+{
+/// The test case of every TEST_CASE, which only differ by name and body.
+struct function_test_case final : public test_case
+{
+    function_test_case(const char *name, void (*fn)(test_case &)) : m_name(name), m_fn(fn) { }
+
+    std::string name() const override { return m_name; }
+    void run() override { m_fn(*this); }
+
+    const char *m_name;
+    void (*m_fn)(test_case &);
+};
+
+/// Stands in for a test case which failed to load, e.g. is not registered, so that it is
+/// reported as failed.
+struct unloaded_test_case final : public test_case
+{
+    unloaded_test_case(std::string name, std::exception_ptr e) :
+        m_name(std::move(name)), m_exception(std::move(e))
+    {
+    }
+
+    std::string name() const override { return m_name; }
+    void run() override { std::rethrow_exception(m_exception); }
+
+    std::string m_name;
+    std::exception_ptr m_exception;
+};
+}
+
+bool test_case::test(const assertion &a)
+{
+    const bool result = a.get_result();
+    m_result = m_result.value_or(true) && result;
+
+    notify_reporters([&](reporter &r) { r.on_assert(std::as_const(*this), a); });
+
+    return result;
+}
+
+bool test_case::test(const assertion_result &r)
+{
+    return test(assertion{
+        r.m_site.m_expr,
+        r.m_op,
+        r.m_result,
+        {},
+        {},
+        r.m_site.m_file,
+        r.m_site.m_line,
+        r.m_lhs_value,
+        r.m_rhs_value});
+}
+
+void test_case::fail(std::exception_ptr e)
+{
+    std::string what = "Unknown exception";
+    try
+    {
+        std::rethrow_exception(e);
+    }
+    catch(const std::exception &ex)
+    {
+        what = ex.what();
+    }
+    catch(...)
+    {
+    }
+    test(assertion{what.c_str(), op::none, false, {}, {}, nullptr, 0, std::nullopt, std::nullopt});
+}
+
+bool register_test_function(const char *name, void (*fn)(test_case &))
+{
+    registry::get_instance().register_test_case(
+        name, [name, fn]() { return std::make_unique<function_test_case>(name, fn); });
+    return true;
+}
 
 void register_reporter(reporter *r) { get_reporters().push_back(r); }
+
+std::string test_case_name(std::string_view id)
+{
+    std::string name;
+    if(!id.empty() && std::isdigit(static_cast<unsigned char>(id.front())))
+        name += '_';
+    for(char c : id)
+        name += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+    return name;
+}
+
+test_series load_test_series(const std::string &filename)
+{
+    std::ifstream is(filename);
+    if(!is)
+        throw std::runtime_error("Failed to open test series " + filename);
+
+    std::vector<std::string> names;
+    for(std::string line; std::getline(is, line);)
+    {
+        if(!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if(line.empty() || line.front() == '#')
+            continue;
+        names.push_back(test_case_name(line));
+    }
+    return test_series(std::filesystem::path(filename).stem().string(), names);
+}
+
+task test_runner::run_test_case(std::string name, async_mutex &blocking)
+{
+    std::unique_ptr<test_case> tc;
+    try
+    {
+        tc = registry::get_instance().load_test_case(name);
+    }
+    catch(...)
+    {
+        tc = std::make_unique<unloaded_test_case>(std::move(name), std::current_exception());
+    }
+
+    const bool is_blocking = tc->is_blocking();
+    if(is_blocking)
+        co_await blocking.lock();
+
+    notify_reporters([&](reporter &r) { r.on_test_starting(*tc); });
+
+    try
+    {
+        co_await tc->run_async();
+    }
+    catch(...)
+    {
+        tc->fail(std::current_exception());
+    }
+
+    notify_reporters([&](reporter &r) { r.on_test_finished(*tc); });
+
+    if(is_blocking)
+        blocking.unlock();
+}
+
+void async_test_case::run()
+{
+    scheduler s;
+    s.spawn(run_async());
+    s.run();
+}
 }
\ No newline at end of file
@@ -16,16 +16,20 @@
  * limitations under the License.
  *****************************************************************************/
 #pragma once
+#include <exception>
 #include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 #include "cat/assertions.h"
+#include "cat/async.h"
 
 namespace cat
 {
@@ -49,8 +53,24 @@ inline std::vector<reporter *> &get_reporters()
     return reporters;
 }
 
+inline std::mutex &get_reporters_mutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
 void register_reporter(reporter *r);
 
+/// Call f on every registered reporter. Calls are serialised so that reporters need not be
+/// thread safe when async test cases run on several threads.
+template <class F>
+void notify_reporters(F &&f)
+{
+    std::lock_guard lock(get_reporters_mutex());
+    for(auto &r : get_reporters())
+        f(*r);
+}
+
 struct test_case
 {
     virtual ~test_case() = default;
@@ -58,24 +78,53 @@ struct test_case
     virtual void run() = 0;
     virtual std::string name() const = 0;
 
-    template <typename AssertionType>
-    bool test(AssertionType &&a)
+    /// Entry point used by the test_runner. Blocking test cases simply run to completion.
+    virtual task run_async()
     {
-        const bool result = a.get_result();
-        m_result = m_result.value_or(true) && result;
-        auto p = std::make_unique<std::decay_t<AssertionType>>(std::forward<AssertionType>(a));
+        run();
+        co_return;
+    }
 
-        for(auto &r : get_reporters())
-            r->on_assert(std::as_const(*this), *p);
+    /// Blocking test cases are run one at a time by the test_runner, as they may share
+    /// instruments without any locking of their own.
+    virtual bool is_blocking() const { return true; }
 
-        return result;
-    }
+    bool test(const assertion &a);
+    bool test(const assertion_result &r);
     bool get_result() const { return m_result.value(); }
 
+    /// Fail the test case with an exception which escaped it, reported as a failed assertion.
+    void fail(std::exception_ptr e);
+
 private:
     std::optional<bool> m_result;
 };
 
+/// Base of the body of a TEST_CASE. Forwards to the test case being run, so that a TEST_CASE
+/// needs no vtable or factory of its own.
+struct test_case_body
+{
+    test_case &m_test_case;
+
+    bool test(const assertion &a) { return m_test_case.test(a); }
+    bool test(const assertion_result &r) { return m_test_case.test(r); }
+    std::string name() const { return m_test_case.name(); }
+};
+
+/// Register a test case which runs fn. Used by TEST_CASE.
+bool register_test_function(const char *name, void (*fn)(test_case &));
+
+/// Test case written as a coroutine, so that waiting on measurements and delays (co_await) does
+/// not hold a runner thread.
+struct async_test_case : public test_case
+{
+    task run_async() override = 0;
+    bool is_blocking() const override { return false; }
+
+    /// Run the coroutine to completion on a private scheduler.
+    void run() override;
+};
+
 class test_series
 {
 public:
@@ -92,6 +141,18 @@ private:
     std::vector<std::string> m_tests;
 };
 
+/// The name under which the test case with the given ID, e.g. from a ReqIF file, is registered:
+/// each character which cannot appear in a C++ identifier is replaced by _ (and a leading digit
+/// is prefixed by _), so that TC-BasicUsage is implemented by TEST_CASE(TC_BasicUsage). Names
+/// which are identifiers already are unchanged.
+std::string test_case_name(std::string_view id);
+
+/// Load a test series from a file with one test case ID per line, e.g. the test selection
+/// written by reqif_tool --diff-old / --diff-new, naming each by test_case_name(). Blank lines and
+/// lines starting with # are skipped. Test cases which are not registered, e.g. not implemented
+/// yet, are kept so that the test_runner reports them as failed.
+test_series load_test_series(const std::string &filename);
+
 using test_case_factory = std::function<std::unique_ptr<test_case>()>;
 
 class registry
@@ -114,7 +175,10 @@ public:
     {
         // Create an object of the test case using the factory function.
         // If it hasn't been registered yet, that should be an exception.
-        return m_registry.at(name)();
+        auto it = m_registry.find(name);
+        if(it == m_registry.end())
+            throw std::runtime_error("Test case not registered: " + name);
+        return it->second();
     }
 
     test_series get_test_series_all()
@@ -133,42 +197,62 @@ private:
 class test_runner
 {
 public:
+    /// \param threads Number of threads the test cases are interleaved on
+    explicit test_runner(std::size_t threads = 1) : m_threads(threads) { }
+
     void run(const test_series &ts)
     {
-        for(auto &r : get_reporters())
-            r->on_test_series_start(ts);
+        notify_reporters([&](reporter &r) { r.on_test_series_start(ts); });
 
+        // Test cases are started in series order. Async test cases interleave whenever they
+        // co_await, while blocking test cases run one at a time even with several threads.
+        async_mutex blocking;
+        scheduler s;
         for(auto &test_case_name : ts.get_tests())
-        {
-            auto tc = registry::get_instance().load_test_case(test_case_name);
+            s.spawn(run_test_case(test_case_name, blocking));
+        s.run(m_threads);
 
-            for(auto &r : get_reporters())
-                r->on_test_starting(*tc);
+        notify_reporters([&](reporter &r) { r.on_test_series_end(ts); });
+    }
 
-            tc->run();
+private:
+    /// Load and run one test case, holding the blocking mutex if it is a blocking test case. A
+    /// test case which is not registered or which throws is reported as failed, and the test
+    /// series carries on.
+    static task run_test_case(std::string name, async_mutex &blocking);
 
-            for(auto &r : get_reporters())
-                r->on_test_finished(*tc);
-        }
-        for(auto &r : get_reporters())
-            r->on_test_series_end(ts);
-    }
+    std::size_t m_threads;
 };
 
+/// Define a blocking test case. A test case implementing one of a ReqIF file is named after its ID
+/// by test_case_name(), e.g. TEST_CASE(TC_BasicUsage) for TC-BasicUsage.
 #define TEST_CASE(Name)                                                                            \
-    struct test_case_##Name : public ::cat::test_case                                              \
+    namespace                                                                                      \
+    {                                                                                              \
+    struct test_case_##Name : public ::cat::test_case_body                                         \
+    {                                                                                              \
+        void run();                                                                                \
+    };                                                                                             \
+    void run_test_case_##Name(::cat::test_case &tc) { test_case_##Name{{tc}}.run(); }              \
+    const bool test_case_##Name##_registered =                                                     \
+        ::cat::register_test_function(#Name, &run_test_case_##Name);                               \
+    }                                                                                              \
+    void test_case_##Name::run()
+
+#define ASYNC_TEST_CASE(Name)                                                                      \
+    struct test_case_##Name : public ::cat::async_test_case                                        \
     {                                                                                              \
         std::string name() const override { return #Name; }                                        \
-        void run() override;                                                                       \
+        ::cat::task run_async() override;                                                          \
                                                                                                    \
     private:                                                                                       \
         static bool m_registered;                                                                  \
     };                                                                                             \
-    bool test_case_##Name## ::m_registered = []                                                    \
+    bool test_case_##Name::m_registered = []                                                       \
     {                                                                                              \
         ::cat::registry::get_instance().register_test_case(                                        \
-            #Name, []() { return std::make_unique<test_case_##Name##>(); });                       \
+            #Name, []() { return std::make_unique<test_case_##Name>(); });                         \
         return true;                                                                               \
     }();                                                                                           \
-    void test_case_##Name::run()
+    ::cat::task test_case_##Name::run_async()
 }
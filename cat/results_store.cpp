@@ -0,0 +1,765 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <set>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+
+#include "results_store.h"
+
+namespace cat
+{
+namespace
+{
+static_assert(std::is_trivially_copyable_v<results_store::block_info>);
+
+const char *dictionary_file = "dictionary.bin";
+const char *manifest_file = "manifest.bin";
+const char *lock_file = "lock";
+
+constexpr double nan = std::numeric_limits<double>::quiet_NaN();
+
+// Bytes per row of the key columns (time, test_case, site, serial), used to filter, and of the
+// data columns (op, result, value, limit). A block stores each column contiguously.
+constexpr std::size_t key_bytes = sizeof(std::int64_t) + 3 * sizeof(std::uint32_t);
+constexpr std::size_t data_bytes = 2 * sizeof(std::uint8_t) + 2 * sizeof(double);
+
+template <class T>
+void put(std::vector<char> &buf, std::size_t &pos, const T &v)
+{
+    std::memcpy(buf.data() + pos, &v, sizeof(T));
+    pos += sizeof(T);
+}
+
+template <class T>
+T get(const std::vector<char> &buf, std::size_t pos)
+{
+    T v;
+    std::memcpy(&v, buf.data() + pos, sizeof(T));
+    return v;
+}
+
+std::vector<char> read_bytes(std::ifstream &is, std::uint64_t offset, std::size_t size)
+{
+    std::vector<char> buf(size);
+    is.seekg(static_cast<std::streamoff>(offset));
+    if(!is.read(buf.data(), static_cast<std::streamsize>(size)))
+        throw std::runtime_error("Failed to read results store block");
+    return buf;
+}
+
+std::uint64_t file_size_or_zero(const std::filesystem::path &p)
+{
+    return std::filesystem::exists(p) ? std::filesystem::file_size(p) : 0U;
+}
+
+std::uint64_t block_end(const results_store::block_info &b)
+{
+    return b.m_offset + (key_bytes + data_bytes) * b.m_rows;
+}
+
+std::string segment_name(const char *kind, std::uint64_t id)
+{
+    return std::string(kind) + "-" + std::to_string(id);
+}
+
+/// The id of a segment file name, e.g. 3 for "log-3.index.bin" and kind "log".
+std::optional<std::uint64_t> segment_id(const std::string &filename, const char *kind)
+{
+    const std::string prefix = std::string(kind) + "-";
+    if(filename.compare(0, prefix.size(), prefix) != 0)
+        return std::nullopt;
+    try
+    {
+        return std::stoull(filename.substr(prefix.size()));
+    }
+    catch(const std::exception &)
+    {
+        return std::nullopt;
+    }
+}
+
+/// Key columns of one block: time[n], test_case[n], site[n], serial[n].
+struct key_columns
+{
+    std::vector<char> m_buf;
+    std::size_t m_rows;
+
+    std::int64_t time(std::size_t u) const { return get<std::int64_t>(m_buf, 8 * u); }
+    std::uint32_t test_case(std::size_t u) const { return id(8, u); }
+    std::uint32_t site(std::size_t u) const { return id(12, u); }
+    std::uint32_t serial(std::size_t u) const { return id(16, u); }
+
+private:
+    std::uint32_t id(std::size_t column, std::size_t u) const
+    {
+        return get<std::uint32_t>(m_buf, column * m_rows + 4 * u);
+    }
+};
+
+key_columns read_keys(std::ifstream &is, const results_store::block_info &b)
+{
+    const auto n = static_cast<std::size_t>(b.m_rows);
+    return key_columns{read_bytes(is, b.m_offset, key_bytes * n), n};
+}
+
+/// Data columns of one block: op[n], result[n], value[n], limit[n].
+void read_data(
+    std::ifstream &is,
+    const results_store::block_info &b,
+    const key_columns &keys,
+    const std::vector<std::size_t> &selected,
+    std::vector<result_row> &rows)
+{
+    const auto n = static_cast<std::size_t>(b.m_rows);
+    auto buf = read_bytes(is, b.m_offset + key_bytes * n, data_bytes * n);
+    for(auto u : selected)
+    {
+        rows.push_back(result_row{
+            keys.time(u),
+            keys.test_case(u),
+            keys.site(u),
+            keys.serial(u),
+            static_cast<op>(get<std::uint8_t>(buf, u)),
+            get<std::uint8_t>(buf, n + u) != 0U,
+            get<double>(buf, 2 * n + 8 * u),
+            get<double>(buf, 10 * n + 8 * u)});
+    }
+}
+
+std::uint64_t row_count(const std::vector<results_store::block_info> &blocks)
+{
+    std::uint64_t n = 0U;
+    for(auto &b : blocks)
+        n += b.m_rows;
+    return n;
+}
+
+/// Compaction order: by test case, site and time.
+bool compaction_less(const result_row &a, const result_row &b)
+{
+    return std::tie(a.m_test_case, a.m_site, a.m_time) <
+           std::tie(b.m_test_case, b.m_site, b.m_time);
+}
+
+/// Reads the rows of a segment in order, one block at a time, or of rows already in memory.
+class segment_reader
+{
+public:
+    segment_reader(
+        const std::filesystem::path &blocks, std::vector<results_store::block_info> index) :
+        m_is(blocks, std::ios::binary), m_index(std::move(index))
+    {
+        next_block();
+    }
+    explicit segment_reader(std::vector<result_row> rows) : m_rows(std::move(rows)) { }
+
+    bool done() const { return m_pos == m_rows.size(); }
+    const result_row &row() const { return m_rows[m_pos]; }
+    void pop()
+    {
+        if(++m_pos == m_rows.size())
+            next_block();
+    }
+
+private:
+    void next_block()
+    {
+        m_rows.clear();
+        m_pos = 0U;
+        for(; m_rows.empty() && m_block != m_index.size(); ++m_block)
+        {
+            auto &b = m_index[m_block];
+            auto keys = read_keys(m_is, b);
+            std::vector<std::size_t> all(keys.m_rows);
+            for(std::size_t u = 0U; u != all.size(); ++u)
+                all[u] = u;
+            read_data(m_is, b, keys, all, m_rows);
+        }
+    }
+
+    std::ifstream m_is;
+    std::vector<results_store::block_info> m_index;
+    std::size_t m_block{0U};
+    std::vector<result_row> m_rows;
+    std::size_t m_pos{0U};
+};
+}
+
+results_store::results_store(std::filesystem::path dir, mode m) :
+    m_dir(std::move(dir)), m_mode(m)
+{
+    if(m_mode == mode::write)
+    {
+        std::filesystem::create_directories(m_dir);
+        // Exclusive create, so that a second writer fails rather than corrupting the store:
+        m_lock = std::fopen((m_dir / lock_file).string().c_str(), "wx");
+        if(!m_lock)
+            throw std::runtime_error(
+                "Results store " + m_dir.string() + " is locked by another writer (remove " +
+                (m_dir / lock_file).string() + " if no writer is running)");
+    }
+    else if(!std::filesystem::is_directory(m_dir))
+        throw std::runtime_error("No results store at " + m_dir.string());
+
+    try
+    {
+        // Load the manifest, the log generation followed by the tier ids:
+        {
+            std::ifstream is(m_dir / manifest_file, std::ios::binary);
+            if(is.read(reinterpret_cast<char *>(&m_generation), sizeof(m_generation)))
+                for(std::uint64_t id; is.read(reinterpret_cast<char *>(&id), sizeof(id));)
+                    m_tier_ids.push_back(id);
+        }
+
+        if(m_mode == mode::write)
+        {
+            // Discard what an interrupted compact() left behind: an uncommitted tier or manifest,
+            // or logs which were compacted before the last compaction.
+            std::filesystem::remove(m_dir / (std::string(manifest_file) + ".tmp"));
+            for(auto &entry : std::filesystem::directory_iterator(m_dir))
+            {
+                const auto filename = entry.path().filename().string();
+                auto tier = segment_id(filename, "tier");
+                auto log = segment_id(filename, "log");
+                if((tier && *tier >= m_generation) || (log && *log + 1U < m_generation))
+                    std::filesystem::remove(entry.path());
+            }
+        }
+
+        // The indexes are read before the dictionary, so that the dictionary holds every string
+        // of the blocks committed so far:
+        for(auto id : m_tier_ids)
+            m_segments.push_back(load_segment(segment_name("tier", id), false));
+        m_segments.push_back(
+            load_segment(segment_name("log", m_generation), m_mode == mode::write));
+        load_dictionary(m_mode == mode::write);
+    }
+    catch(...)
+    {
+        if(m_lock)
+        {
+            std::fclose(m_lock);
+            std::filesystem::remove(m_dir / lock_file);
+        }
+        throw;
+    }
+}
+
+results_store::~results_store()
+{
+    if(m_lock)
+    {
+        std::fclose(m_lock);
+        std::error_code ec;
+        std::filesystem::remove(m_dir / lock_file, ec);
+    }
+}
+
+std::filesystem::path results_store::blocks_path(const std::string &name) const
+{
+    return m_dir / (name + ".blocks.bin");
+}
+
+std::filesystem::path results_store::index_path(const std::string &name) const
+{
+    return m_dir / (name + ".index.bin");
+}
+
+results_store::segment results_store::load_segment(std::string name, bool recover) const
+{
+    // Blocks not in the index were never committed, nor is a torn index entry:
+    segment s{std::move(name), {}};
+    const auto index = index_path(s.m_name);
+    const auto index_size = file_size_or_zero(index);
+    const auto count = index_size / sizeof(block_info);
+    s.m_blocks.resize(count);
+    std::ifstream is(index, std::ios::binary);
+    if(count && !is.read(
+                    reinterpret_cast<char *>(s.m_blocks.data()),
+                    static_cast<std::streamsize>(count * sizeof(block_info))))
+        throw std::runtime_error("Failed to read results store index " + index.string());
+
+    const std::uint64_t end = s.m_blocks.empty() ? 0U : block_end(s.m_blocks.back());
+    const auto blocks = blocks_path(s.m_name);
+    const auto size = file_size_or_zero(blocks);
+    if(size < end)
+        throw std::runtime_error(
+            "Results store blocks are shorter than the index: " + blocks.string());
+
+    if(recover)
+    {
+        if(index_size != count * sizeof(block_info))
+            std::filesystem::resize_file(index, count * sizeof(block_info));
+        if(size > end)
+            std::filesystem::resize_file(blocks, end);
+    }
+    return s;
+}
+
+void results_store::load_dictionary(bool recover)
+{
+    // Stop at a torn record at the end:
+    const auto path = m_dir / dictionary_file;
+    std::ifstream is(path, std::ios::binary);
+    std::uint64_t good = 0U;
+    std::uint32_t len = 0U;
+    while(is.read(reinterpret_cast<char *>(&len), sizeof(len)))
+    {
+        std::string s(len, '\0');
+        if(!is.read(s.data(), len))
+            break;
+        m_ids.emplace(s, static_cast<std::uint32_t>(m_strings.size()));
+        m_strings.push_back(std::move(s));
+        good += sizeof(len) + len;
+    }
+    if(recover && file_size_or_zero(path) != good)
+        std::filesystem::resize_file(path, good);
+}
+
+void results_store::write_manifest(
+    std::uint64_t generation, const std::vector<std::uint64_t> &tiers)
+{
+    // Commit by replacing the manifest, which readers load first:
+    const auto tmp = m_dir / (std::string(manifest_file) + ".tmp");
+    {
+        std::ofstream os(tmp, std::ios::binary | std::ios::trunc);
+        os.write(reinterpret_cast<const char *>(&generation), sizeof(generation));
+        os.write(
+            reinterpret_cast<const char *>(tiers.data()),
+            static_cast<std::streamsize>(tiers.size() * sizeof(std::uint64_t)));
+        os.flush();
+        if(!os)
+            throw std::runtime_error("Failed to write results store manifest");
+    }
+    std::filesystem::rename(tmp, m_dir / manifest_file);
+}
+
+void results_store::check_writable() const
+{
+    if(m_mode != mode::write)
+        throw std::logic_error("Results store " + m_dir.string() + " is open for reading only");
+}
+
+std::size_t results_store::block_count() const
+{
+    std::size_t n = 0U;
+    for(auto &s : m_segments)
+        n += s.m_blocks.size();
+    return n;
+}
+
+std::uint32_t results_store::intern(const std::string &s)
+{
+    auto [it, was_inserted] = m_ids.emplace(s, static_cast<std::uint32_t>(m_strings.size()));
+    if(was_inserted)
+    {
+        std::ofstream os(m_dir / dictionary_file, std::ios::binary | std::ios::app);
+        const auto len = static_cast<std::uint32_t>(s.size());
+        os.write(reinterpret_cast<const char *>(&len), sizeof(len));
+        os.write(s.data(), static_cast<std::streamsize>(s.size()));
+        if(!os)
+            throw std::runtime_error("Failed to write results store dictionary");
+        m_strings.push_back(s);
+    }
+    return it->second;
+}
+
+std::optional<std::uint32_t> results_store::find(const std::optional<std::string> &s) const
+{
+    if(!s)
+        return std::nullopt;
+    auto it = m_ids.find(*s);
+    if(it == m_ids.end())
+        return std::numeric_limits<std::uint32_t>::max(); // Matches nothing
+    return it->second;
+}
+
+void results_store::append(const std::vector<result_record> &records)
+{
+    check_writable();
+    if(records.empty())
+        return;
+
+    std::vector<result_row> rows;
+    rows.reserve(records.size());
+    for(auto &r : records)
+    {
+        rows.push_back(result_row{
+            r.m_time,
+            intern(r.m_test_case),
+            intern(r.m_site),
+            intern(r.m_serial),
+            r.m_op,
+            r.m_result,
+            r.m_value,
+            r.m_limit});
+    }
+    write_blocks(m_segments.back(), rows, rows.size());
+}
+
+void results_store::write_blocks(
+    segment &s, const std::vector<result_row> &rows, std::size_t rows_per_block)
+{
+    std::ofstream blocks(blocks_path(s.m_name), std::ios::binary | std::ios::app);
+    std::ofstream index(index_path(s.m_name), std::ios::binary | std::ios::app);
+    std::uint64_t offset = s.m_blocks.empty() ? 0U : block_end(s.m_blocks.back());
+
+    for(std::size_t first = 0U; first < rows.size(); first += rows_per_block)
+    {
+        const std::size_t n = std::min(rows_per_block, rows.size() - first);
+        const auto begin = rows.begin() + static_cast<std::ptrdiff_t>(first);
+        const auto end = begin + static_cast<std::ptrdiff_t>(n);
+
+        block_info b{};
+        b.m_offset = offset;
+        b.m_rows = n;
+        b.m_time_min = b.m_time_max = begin->m_time;
+        b.m_test_case_min = b.m_test_case_max = begin->m_test_case;
+        b.m_site_min = b.m_site_max = begin->m_site;
+        b.m_serial_min = b.m_serial_max = begin->m_serial;
+        b.m_value_min = std::numeric_limits<double>::infinity();
+        b.m_value_max = -std::numeric_limits<double>::infinity();
+
+        std::vector<char> buf((key_bytes + data_bytes) * n);
+        std::size_t pos = 0U;
+        // clang-format off
+        for(auto it = begin; it != end; ++it) put(buf, pos, it->m_time);
+        for(auto it = begin; it != end; ++it) put(buf, pos, it->m_test_case);
+        for(auto it = begin; it != end; ++it) put(buf, pos, it->m_site);
+        for(auto it = begin; it != end; ++it) put(buf, pos, it->m_serial);
+        for(auto it = begin; it != end; ++it) put(buf, pos, static_cast<std::uint8_t>(it->m_op));
+        for(auto it = begin; it != end; ++it) put(buf, pos, static_cast<std::uint8_t>(it->m_result));
+        for(auto it = begin; it != end; ++it) put(buf, pos, it->m_value);
+        for(auto it = begin; it != end; ++it) put(buf, pos, it->m_limit);
+        // clang-format on
+
+        for(auto it = begin; it != end; ++it)
+        {
+            b.m_time_min = std::min(b.m_time_min, it->m_time);
+            b.m_time_max = std::max(b.m_time_max, it->m_time);
+            b.m_test_case_min = std::min(b.m_test_case_min, it->m_test_case);
+            b.m_test_case_max = std::max(b.m_test_case_max, it->m_test_case);
+            b.m_site_min = std::min(b.m_site_min, it->m_site);
+            b.m_site_max = std::max(b.m_site_max, it->m_site);
+            b.m_serial_min = std::min(b.m_serial_min, it->m_serial);
+            b.m_serial_max = std::max(b.m_serial_max, it->m_serial);
+            if(!std::isnan(it->m_value))
+            {
+                b.m_value_min = std::min(b.m_value_min, it->m_value);
+                b.m_value_max = std::max(b.m_value_max, it->m_value);
+            }
+        }
+
+        // Commit the block by writing its index entry last:
+        blocks.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+        blocks.flush();
+        index.write(reinterpret_cast<const char *>(&b), sizeof(b));
+        index.flush();
+        if(!blocks || !index)
+            throw std::runtime_error("Failed to write results store block");
+
+        s.m_blocks.push_back(b);
+        offset += buf.size();
+    }
+}
+
+std::vector<result_row> results_store::query(const results_query &q) const
+{
+    const auto test_case = find(q.m_test_case);
+    const auto site = find(q.m_site);
+    const auto serial = find(q.m_serial);
+    const auto from = q.m_from.value_or(std::numeric_limits<std::int64_t>::min());
+    const auto to = q.m_to.value_or(std::numeric_limits<std::int64_t>::max());
+
+    auto in = [](std::optional<std::uint32_t> id, std::uint32_t lo, std::uint32_t hi)
+    { return !id || (*id >= lo && *id <= hi); };
+    auto match = [](std::optional<std::uint32_t> id, std::uint32_t v) { return !id || *id == v; };
+
+    std::vector<result_row> rows;
+    std::vector<std::size_t> selected;
+    for(auto &s : m_segments)
+    {
+        std::ifstream is(blocks_path(s.m_name), std::ios::binary);
+        for(auto &b : s.m_blocks)
+        {
+            // Skip blocks using the min/max index:
+            if(!in(test_case, b.m_test_case_min, b.m_test_case_max) ||
+               !in(site, b.m_site_min, b.m_site_max) ||
+               !in(serial, b.m_serial_min, b.m_serial_max) || b.m_time_max < from ||
+               b.m_time_min > to)
+                continue;
+
+            auto keys = read_keys(is, b);
+            selected.clear();
+            for(std::size_t u = 0U; u != keys.m_rows; ++u)
+            {
+                const auto t = keys.time(u);
+                if(t >= from && t <= to && match(test_case, keys.test_case(u)) &&
+                   match(site, keys.site(u)) && match(serial, keys.serial(u)))
+                    selected.push_back(u);
+            }
+            if(!selected.empty())
+                read_data(is, b, keys, selected, rows);
+        }
+    }
+
+    std::stable_sort(
+        rows.begin(),
+        rows.end(),
+        [](const result_row &a, const result_row &b) { return a.m_time < b.m_time; });
+    return rows;
+}
+
+std::vector<std::pair<std::uint32_t, std::uint32_t>> results_store::sites() const
+{
+    std::set<std::pair<std::uint32_t, std::uint32_t>> sites;
+    for(auto &s : m_segments)
+    {
+        std::ifstream is(blocks_path(s.m_name), std::ios::binary);
+        for(auto &b : s.m_blocks)
+        {
+            // A compacted block usually holds a single site:
+            if(b.m_test_case_min == b.m_test_case_max && b.m_site_min == b.m_site_max)
+            {
+                sites.emplace(b.m_test_case_min, b.m_site_min);
+                continue;
+            }
+            auto keys = read_keys(is, b);
+            for(std::size_t u = 0U; u != keys.m_rows; ++u)
+                sites.emplace(keys.test_case(u), keys.site(u));
+        }
+    }
+    return {sites.begin(), sites.end()};
+}
+
+std::vector<result_row> results_store::read_all(const segment &s) const
+{
+    std::vector<result_row> rows;
+    for(segment_reader r(blocks_path(s.m_name), s.m_blocks); !r.done(); r.pop())
+        rows.push_back(r.row());
+    return rows;
+}
+
+void results_store::compact(std::size_t rows_per_block)
+{
+    check_writable();
+    if(m_segments.back().m_blocks.empty())
+        return;
+
+    // Sort the log, and decide which of the newest tiers to merge with it so that each tier
+    // holds more than merge_factor times the rows of all newer tiers together. Then there are
+    // O(log n) tiers for queries to open, and each row is rewritten O(log n) times (amortised).
+    auto rows = read_all(m_segments.back());
+    std::stable_sort(rows.begin(), rows.end(), compaction_less);
+
+    const std::size_t tier_count = m_tier_ids.size();
+    std::size_t merged = 0U;
+    std::uint64_t newer_rows = rows.size();
+    for(; merged != tier_count; ++merged)
+    {
+        const auto n = row_count(m_segments[tier_count - 1U - merged].m_blocks);
+        if(n > merge_factor * newer_rows)
+            break;
+        newer_rows += n;
+    }
+
+    // Merge the tiers, oldest first so that equal keys keep their order, and the log, a block at
+    // a time:
+    std::vector<segment_reader> sources;
+    for(std::size_t u = tier_count - merged; u != tier_count; ++u)
+        sources.emplace_back(blocks_path(m_segments[u].m_name), m_segments[u].m_blocks);
+    sources.emplace_back(std::move(rows));
+
+    // Write the tier, named after the log it came from, and commit it along with a new log:
+    segment tier{segment_name("tier", m_generation), {}};
+    std::filesystem::remove(blocks_path(tier.m_name));
+    std::filesystem::remove(index_path(tier.m_name));
+    std::vector<result_row> block;
+    while(true)
+    {
+        segment_reader *next = nullptr;
+        for(auto &source : sources)
+            if(!source.done() && (!next || compaction_less(source.row(), next->row())))
+                next = &source;
+        if(next)
+        {
+            block.push_back(next->row());
+            next->pop();
+        }
+        if(block.size() == rows_per_block || (!next && !block.empty()))
+        {
+            write_blocks(tier, block, rows_per_block);
+            block.clear();
+        }
+        if(!next)
+            break;
+    }
+
+    std::vector<std::uint64_t> tier_ids(m_tier_ids.begin(), m_tier_ids.end() - merged);
+    tier_ids.push_back(m_generation);
+    write_manifest(m_generation + 1U, tier_ids);
+
+    // The previous log, and the tiers merged by the previous compaction, are kept until now for
+    // the readers which opened before that compaction:
+    if(m_generation > 0U)
+    {
+        std::filesystem::remove(blocks_path(segment_name("log", m_generation - 1U)));
+        std::filesystem::remove(index_path(segment_name("log", m_generation - 1U)));
+    }
+    for(auto &entry : std::filesystem::directory_iterator(m_dir))
+    {
+        auto id = segment_id(entry.path().filename().string(), "tier");
+        auto listed = [&](const std::vector<std::uint64_t> &ids)
+        { return id && std::find(ids.begin(), ids.end(), *id) != ids.end(); };
+        if(id && !listed(m_tier_ids) && !listed(tier_ids))
+            std::filesystem::remove(entry.path());
+    }
+
+    ++m_generation;
+    m_tier_ids = std::move(tier_ids);
+    m_segments.erase(m_segments.end() - 1 - static_cast<std::ptrdiff_t>(merged), m_segments.end());
+    m_segments.push_back(std::move(tier));
+    m_segments.push_back(segment{segment_name("log", m_generation), {}});
+}
+
+double margin(const result_row &r)
+{
+    switch(r.m_op)
+    {
+    case op::le:
+    case op::l:
+        return r.m_limit - r.m_value;
+    case op::ge:
+    case op::g:
+        return r.m_value - r.m_limit;
+    default:
+        return nan;
+    }
+}
+
+margin_histogram margin_distribution(const std::vector<result_row> &rows, std::size_t bins)
+{
+    std::vector<double> margins;
+    for(auto &r : rows)
+    {
+        const double m = margin(r);
+        if(!std::isnan(m))
+            margins.push_back(m);
+    }
+
+    margin_histogram h;
+    if(margins.empty() || bins == 0U)
+        return h;
+
+    auto [lo, hi] = std::minmax_element(margins.begin(), margins.end());
+    h.m_min = *lo;
+    h.m_max = *hi;
+    h.m_counts.assign(bins, 0U);
+    const double width = (h.m_max - h.m_min) / static_cast<double>(bins);
+    for(double m : margins)
+    {
+        auto bin = width > 0.0 ? static_cast<std::size_t>((m - h.m_min) / width) : 0U;
+        ++h.m_counts[std::min(bin, bins - 1U)];
+    }
+    return h;
+}
+
+spc_result spc(const std::vector<result_row> &rows, std::size_t baseline)
+{
+    // Indexes of the rows with a measured value, e.g. not of == or non arithmetic asserts:
+    std::vector<std::size_t> points;
+    for(std::size_t u = 0U; u != rows.size(); ++u)
+        if(!std::isnan(rows[u].m_value))
+            points.push_back(u);
+
+    spc_result s;
+    const std::size_t n = baseline == 0U ? points.size() : std::min(baseline, points.size());
+    if(n == 0U)
+        return s;
+
+    for(std::size_t u = 0U; u != n; ++u)
+        s.m_mean += rows[points[u]].m_value;
+    s.m_mean /= static_cast<double>(n);
+
+    for(std::size_t u = 0U; u != n; ++u)
+        s.m_sigma += (rows[points[u]].m_value - s.m_mean) * (rows[points[u]].m_value - s.m_mean);
+    s.m_sigma = n > 1U ? std::sqrt(s.m_sigma / static_cast<double>(n - 1U)) : 0.0;
+    s.m_lcl = s.m_mean - 3.0 * s.m_sigma;
+    s.m_ucl = s.m_mean + 3.0 * s.m_sigma;
+
+    int side_run = 0;  // > 0 above the mean, < 0 below
+    int trend_run = 0; // > 0 increasing, < 0 decreasing
+    for(std::size_t u = 0U; u != points.size(); ++u)
+    {
+        const std::size_t index = points[u];
+        const double v = rows[index].m_value;
+        if(v < s.m_lcl || v > s.m_ucl)
+            s.m_violations.push_back({index, 1});
+
+        const int side = v > s.m_mean ? 1 : (v < s.m_mean ? -1 : 0);
+        side_run = side == 0 ? 0 : ((side_run * side > 0) ? side_run + side : side);
+        if(std::abs(side_run) == 9)
+            s.m_violations.push_back({index, 2});
+
+        if(u > 0U)
+        {
+            const double prev = rows[points[u - 1U]].m_value;
+            const int dir = v > prev ? 1 : (v < prev ? -1 : 0);
+            trend_run = dir == 0 ? 0 : ((trend_run * dir > 0) ? trend_run + dir : dir);
+            // Six points increasing means five increasing steps:
+            if(std::abs(trend_run) == 5)
+                s.m_violations.push_back({index, 3});
+        }
+    }
+    return s;
+}
+
+void results_store_reporter::on_assert(const test_case &tc, const assertion &a)
+{
+    const auto now = std::chrono::system_clock::now().time_since_epoch();
+    std::string site = a.m_file ? std::filesystem::path(a.m_file).filename().string() : "";
+    site += ":" + std::to_string(a.m_line);
+
+    m_records.push_back(result_record{
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now).count(),
+        tc.name(),
+        std::move(site),
+        m_serial,
+        a.m_op,
+        a.get_result(),
+        a.m_lhs_value.value_or(nan),
+        a.m_rhs_value.value_or(nan)});
+}
+
+void results_store_reporter::on_test_finished(const test_case &tc) { flush(); }
+
+void results_store_reporter::on_test_series_end(const test_series &ts) { flush(); }
+
+void results_store_reporter::flush()
+{
+    m_store.append(m_records);
+    m_records.clear();
+}
+}
@@ -0,0 +1,224 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "cat/cat.h"
+
+namespace cat
+{
+
+/// One assertion of one run, as ingested into the results store.
+struct result_record
+{
+    std::int64_t m_time; //!< Nanoseconds since the epoch
+    std::string m_test_case;
+    std::string m_site; //!< Assertion site, e.g. "main.cpp:42"
+    std::string m_serial; //!< Unit (DUT) serial number
+    op m_op;
+    bool m_result;
+    double m_value; //!< Measured value (LHS), NaN if not arithmetic
+    double m_limit; //!< Limit (RHS), NaN if not arithmetic
+};
+
+/// A row returned by a query. Strings are dictionary ids, see results_store::lookup.
+struct result_row
+{
+    std::int64_t m_time;
+    std::uint32_t m_test_case;
+    std::uint32_t m_site;
+    std::uint32_t m_serial;
+    op m_op;
+    bool m_result;
+    double m_value;
+    double m_limit;
+};
+
+struct results_query
+{
+    std::optional<std::string> m_test_case;
+    std::optional<std::string> m_site;
+    std::optional<std::string> m_serial;
+    std::optional<std::int64_t> m_from; //!< Inclusive, nanoseconds since the epoch
+    std::optional<std::int64_t> m_to;   //!< Inclusive, nanoseconds since the epoch
+};
+
+/// Embedded, append optimised, columnar store of assertion results across runs.
+///
+/// The store is a directory holding:
+/// - dictionary.bin: the interned strings (test cases, sites, serials), length prefixed
+/// - log-<n>.blocks.bin: blocks of rows appended since the last compact(), stored column by
+///   column, with log-<n>.index.bin holding one block_info per block with the per column
+///   min/max, used to skip blocks
+/// - tier-<n>.blocks.bin / tier-<n>.index.bin: the rows of log <n>, sorted by compact() and
+///   merged with those of the newest tiers
+/// - manifest.bin: the current log and the committed tiers
+///
+/// Each append writes one block to the log and commits it by appending to the log index last,
+/// so a torn write is ignored. compact() sorts the log, by test case, site and time, into a new
+/// tier so that the min/max ranges are narrow and queries touch few blocks, and commits it by
+/// replacing the manifest. Like an LSM tree, small tiers are merged into larger ones as they
+/// grow, so that the number of tiers stays logarithmic in the number of rows.
+///
+/// One writer and any number of readers may have the store open at once. A writer holds the
+/// lock file "lock" (left behind if the writer crashed, remove it once no writer is running) and
+/// rolls back torn writes when opening. Readers never modify the store; a reader sees the store
+/// as it was when opened, up to the second compact() after that.
+class results_store
+{
+public:
+    enum class mode
+    {
+        read,  // The store must exist
+        write, // The store is created if need be
+    };
+
+    explicit results_store(std::filesystem::path dir, mode m = mode::read);
+    ~results_store();
+    results_store(const results_store &) = delete;
+    results_store &operator=(const results_store &) = delete;
+
+    void append(const std::vector<result_record> &records);
+
+    /// Rows matching the query, sorted by time.
+    std::vector<result_row> query(const results_query &q) const;
+
+    /// Distinct (test case, site) pairs in the store.
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> sites() const;
+
+    /// Sort the blocks appended since the last compaction into a new tier of blocks of up to
+    /// rows_per_block rows, merged with the newest tiers unless each of those holds more than
+    /// merge_factor times the rows of the tiers newer than it (and of the log) together.
+    void compact(std::size_t rows_per_block = 65536U);
+
+    static constexpr std::uint64_t merge_factor = 4U;
+
+    const std::string &lookup(std::uint32_t id) const { return m_strings.at(id); }
+    std::size_t block_count() const;
+    std::size_t tier_count() const { return m_tier_ids.size(); }
+
+    struct block_info
+    {
+        std::uint64_t m_offset;
+        std::uint64_t m_rows;
+        std::int64_t m_time_min, m_time_max;
+        std::uint32_t m_test_case_min, m_test_case_max;
+        std::uint32_t m_site_min, m_site_max;
+        std::uint32_t m_serial_min, m_serial_max;
+        double m_value_min, m_value_max;
+    };
+
+private:
+    /// The blocks of a log or a tier.
+    struct segment
+    {
+        std::string m_name; //!< e.g. "log-3", "tier-2"
+        std::vector<block_info> m_blocks;
+    };
+
+    std::filesystem::path blocks_path(const std::string &name) const;
+    std::filesystem::path index_path(const std::string &name) const;
+    segment load_segment(std::string name, bool recover) const;
+    void load_dictionary(bool recover);
+    void write_manifest(std::uint64_t generation, const std::vector<std::uint64_t> &tiers);
+    void check_writable() const;
+
+    std::uint32_t intern(const std::string &s);
+    std::optional<std::uint32_t> find(const std::optional<std::string> &s) const;
+    void write_blocks(segment &s, const std::vector<result_row> &rows, std::size_t rows_per_block);
+    std::vector<result_row> read_all(const segment &s) const;
+
+    std::filesystem::path m_dir;
+    mode m_mode;
+    std::FILE *m_lock{nullptr};
+    std::uint64_t m_generation{0U}; //!< Of the log
+    std::vector<std::uint64_t> m_tier_ids;
+    std::vector<segment> m_segments; //!< The tiers, oldest first, then the log
+    std::vector<std::string> m_strings;
+    std::unordered_map<std::string, std::uint32_t> m_ids;
+};
+
+/// Distance from the measured value to the limit, positive inside the limit and negative
+/// outside. NaN for comparisons without a one sided limit (==, !=, &&).
+double margin(const result_row &r);
+
+struct margin_histogram
+{
+    double m_min{0.0};
+    double m_max{0.0};
+    std::vector<std::size_t> m_counts; //!< Equal width bins from m_min to m_max
+};
+
+margin_histogram margin_distribution(const std::vector<result_row> &rows, std::size_t bins);
+
+struct spc_violation
+{
+    std::size_t m_index; //!< Index into the rows
+    int m_rule;          //!< Nelson rule: 1, 2 or 3
+};
+
+struct spc_result
+{
+    double m_mean{0.0};
+    double m_sigma{0.0};
+    double m_lcl{0.0}; //!< Lower control limit, mean - 3 sigma
+    double m_ucl{0.0}; //!< Upper control limit, mean + 3 sigma
+    std::vector<spc_violation> m_violations;
+};
+
+/// Individuals control chart of the measured values of one assertion site, in time order. Rows
+/// without a measured value (NaN) are skipped.
+///
+/// The control limits are estimated from the first baseline values (all if 0). Flags:
+/// 1. a point outside the control limits
+/// 2. nine points in a row on the same side of the mean (shift)
+/// 3. six points in a row steadily increasing or decreasing (drift)
+spc_result spc(const std::vector<result_row> &rows, std::size_t baseline = 0U);
+
+/// Ingests every assertion of the test series into a results store, keyed by test case,
+/// assertion site and unit serial. The records are appended as each test case finishes, so that
+/// a series which is cut short keeps the results of the test cases which ran.
+class results_store_reporter : public reporter
+{
+public:
+    results_store_reporter(results_store &store, std::string serial) :
+        m_store(store), m_serial(std::move(serial))
+    {
+    }
+
+    void on_assert(const test_case &tc, const assertion &a) override;
+    void on_test_finished(const test_case &tc) override;
+    void on_test_series_end(const test_series &ts) override;
+
+    /// Append the records not yet in the store.
+    void flush();
+
+private:
+    results_store &m_store;
+    std::string m_serial;
+    std::vector<result_record> m_records;
+};
+}
@@ -0,0 +1,188 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <algorithm>
+#include <deque>
+#include <set>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "cat/cat.h"
+
+#include "diff.h"
+
+namespace reqif
+{
+namespace
+{
+// FNV-1a
+std::uint64_t hash(std::string_view s, std::uint64_t h = 14695981039346656037ULL)
+{
+    for(unsigned char c : s)
+        h = (h ^ c) * 1099511628211ULL;
+    return h;
+}
+
+// Finaliser from splitmix64, so that summing per attribute hashes still mixes well.
+std::uint64_t mix(std::uint64_t h)
+{
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}
+
+std::uint64_t hash(const std::vector<attr> &values)
+{
+    // Sum, so that reordering the attribute values is not a change:
+    std::uint64_t h = 0U;
+    for(auto &a : values)
+        h += mix(hash(a.m_value, hash(std::string_view("\0", 1), hash(a.m_defn))));
+    return h;
+}
+
+/// Merge the two maps (both sorted by identifier) and record the differences.
+template <class T>
+void compare(
+    const std::map<std::string, T> &old_map,
+    const std::map<std::string, T> &new_map,
+    std::vector<diff_entry> &entries)
+{
+    auto it_old = old_map.begin();
+    auto it_new = new_map.begin();
+    while(it_old != old_map.end() || it_new != new_map.end())
+    {
+        if(it_new == new_map.end() || (it_old != old_map.end() && it_old->first < it_new->first))
+        {
+            entries.push_back({it_old->first, change::removed});
+            ++it_old;
+        }
+        else if(it_old == old_map.end() || it_new->first < it_old->first)
+        {
+            entries.push_back({it_new->first, change::added});
+            ++it_new;
+        }
+        else
+        {
+            if(content_hash(it_old->second) != content_hash(it_new->second))
+                entries.push_back({it_new->first, change::modified});
+            ++it_old;
+            ++it_new;
+        }
+    }
+}
+
+std::string get_spec_type_id(const file &f, const std::string &name)
+{
+    for(auto &[id, st] : f.m_spec_types)
+        if(st.m_name == name)
+            return id;
+    throw std::runtime_error("No SPEC-OBJECT-TYPE named " + name);
+}
+}
+
+std::uint64_t content_hash(const spec_obj &so) { return mix(hash(so.m_type) + hash(so.m_values)); }
+
+std::uint64_t content_hash(const spec_relation &sr)
+{
+    std::uint64_t h = hash(sr.m_type);
+    h = hash(sr.m_source, hash(std::string_view("\0", 1), h));
+    h = hash(sr.m_target, hash(std::string_view("\0", 1), h));
+    return mix(h + hash(sr.m_values));
+}
+
+diff compare(const file &old_file, const file &new_file)
+{
+    diff d;
+    compare(old_file.m_spec_objs, new_file.m_spec_objs, d.m_spec_objs);
+    compare(old_file.m_spec_relations, new_file.m_spec_relations, d.m_spec_relations);
+    return d;
+}
+
+std::vector<std::string> select_test_cases(
+    const file &old_file,
+    const file &new_file,
+    const diff &d,
+    const std::string &test_case_type,
+    const std::string &id_attr)
+{
+    // Seed with the changed spec objects and the sources of the changed relations (old and new,
+    // since a removed trace also affects its source):
+    std::deque<const std::string *> pending;
+    std::unordered_set<std::string_view> visited;
+    auto visit = [&](const std::string &id)
+    {
+        if(visited.insert(id).second)
+            pending.push_back(&id);
+    };
+
+    for(auto &e : d.m_spec_objs)
+        visit(e.m_id);
+
+    for(auto &e : d.m_spec_relations)
+    {
+        for(auto *f : {&old_file, &new_file})
+        {
+            auto it = f->m_spec_relations.find(e.m_id);
+            if(it != f->m_spec_relations.end())
+                visit(it->second.m_source);
+        }
+    }
+
+    // Walk the relations backwards (target -> source) in the new file:
+    std::unordered_map<std::string_view, std::vector<const std::string *>> sources;
+    for(auto &[id, sr] : new_file.m_spec_relations)
+        sources[sr.m_target].push_back(&sr.m_source);
+
+    while(!pending.empty())
+    {
+        auto id = pending.front();
+        pending.pop_front();
+
+        auto it = sources.find(*id);
+        if(it != sources.end())
+            for(auto source : it->second)
+                visit(*source);
+    }
+
+    // The affected test cases are the visited spec objects of the test case type:
+    const auto type_id = get_spec_type_id(new_file, test_case_type);
+    std::string id_attr_defn;
+    for(auto &ad : new_file.m_spec_types.at(type_id).m_attr_defs)
+        if(ad.m_name == id_attr)
+            id_attr_defn = ad.m_id;
+    if(id_attr_defn.empty())
+        throw std::runtime_error(
+            "No attribute " + id_attr + " in SPEC-OBJECT-TYPE " + test_case_type);
+
+    std::set<std::string> selection;
+    for(auto id : visited)
+    {
+        auto it = new_file.m_spec_objs.find(std::string(id));
+        if(it == new_file.m_spec_objs.end() || it->second.m_type != type_id)
+            continue;
+
+        auto &values = it->second.m_values;
+        auto it_name = std::find_if(
+            values.begin(), values.end(), [&](const attr &a) { return a.m_defn == id_attr_defn; });
+        if(it_name != values.end() && !it_name->m_value.empty())
+            selection.insert(cat::test_case_name(it_name->m_value));
+    }
+    return {selection.begin(), selection.end()};
+}
+}
@@ -0,0 +1,71 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "reqif.h"
+
+namespace reqif
+{
+enum class change
+{
+    added,    // Only in the new file
+    removed,  // Only in the old file
+    modified, // In both files, but the content hash differs
+};
+
+struct diff_entry
+{
+    std::string m_id; //!< IDENTIFIER of the SPEC-OBJECT / SPEC-RELATION
+    change m_change;
+};
+
+struct diff
+{
+    std::vector<diff_entry> m_spec_objs;
+    std::vector<diff_entry> m_spec_relations;
+
+    bool empty() const { return m_spec_objs.empty() && m_spec_relations.empty(); }
+};
+
+/// Hash of the type and attribute values, independent of the attribute order.
+std::uint64_t content_hash(const spec_obj &so);
+
+/// Hash of the type, source, target and attribute values.
+std::uint64_t content_hash(const spec_relation &sr);
+
+/// Diff two ReqIF files by identifier and content hash.
+diff compare(const file &old_file, const file &new_file);
+
+/// Select the test cases affected by the diff.
+///
+/// A test case is affected if it changed itself, or if it traces (following the relations from
+/// source to target, e.g. TestCase -> Tests -> TestRequirement -> Refines -> Requirement) to a
+/// spec object which changed or whose relations changed.
+/// \param test_case_type Name of the SPEC-OBJECT-TYPE defining test cases, e.g. "TestCase"
+/// \param id_attr Name of the test case attribute holding the test case name, e.g. "ID"
+/// \return Sorted names of the TEST_CASEs, i.e. cat::test_case_name() of each test case ID
+std::vector<std::string> select_test_cases(
+    const file &old_file,
+    const file &new_file,
+    const diff &d,
+    const std::string &test_case_type,
+    const std::string &id_attr);
+}
@@ -16,197 +16,114 @@
  * limitations under the License.
  *****************************************************************************/
 #include <fstream>
-#include <map>
-#include <sstream>
+#include <future>
+#include <iostream>
 #include <string>
 #include <utility>
 #include <vector>
 
-#include <pugixml.hpp>
-
-#include <iostream>
-
-namespace reqif
-{
-class data_type
-{
-public:
-    std::string m_id;
-    std::string m_name;
-};
-
-class attr_def
-{
-public:
-    std::string m_id;
-    std::string m_name;
-    std::string m_data_type;
-};
+#include <cxxopts.hpp>
 
-class spec_type
-{
-public:
-    std::string m_id;
-    std::string m_name;
-    std::vector<attr_def> m_attr_defs;
-};
+#include "diff.h"
+#include "reqif.h"
 
-class attr
+namespace
 {
-public:
-    std::string m_defn;  //!< Reference to the attribute definition
-    std::string m_value; //!< Attribute contents
-};
-
-class spec_obj
+const char *to_string(reqif::change c)
 {
-public:
-    std::string m_id;
-    std::string m_type;
-    std::vector<attr> m_values;
-};
-
-class spec_relation
-{
-public:
-    std::string m_id;
-    std::string m_source;
-    std::string m_target;
-    std::string m_type;
-};
-
-class spec_entry
-{
-public:
-    std::string m_spec_obj;
-    std::vector<spec_entry> m_children;
-};
-
-class specification
-{
-    std::string m_id;
-    std::string m_name;
-    std::vector<spec_entry> m_children;
-};
-
-class file
-{
-public:
-    std::map<std::string, data_type> m_data_types;
-    std::map<std::string, spec_type> m_spec_types;
-    std::map<std::string, spec_relation> m_spec_relations;
-    std::map<std::string, spec_obj> m_spec_objs;
-};
-
-std::string get_xml_content(const pugi::xml_node &node)
-{
-    std::ostringstream os;
-    for(auto &child : node.children())
-        child.print(os, "", pugi::format_raw);
-    return os.str();
-}
-
-std::vector<attr> parse_attributes(const pugi::xml_node &attr_values_node)
-{
-    std::vector<attr> attrs;
-
-    for(auto &v : attr_values_node.children())
+    switch(c)
     {
-        std::string attr_class = v.name();
-
-        reqif::attr a;
-        a.m_defn = v.child("DEFINITION").first_child().text().as_string();
-
-        if(attr_class == "ATTRIBUTE-VALUE-STRING")
-            a.m_value = v.attribute("THE-VALUE").as_string();
-        else if(attr_class == "ATTRIBUTE-VALUE-XHTML")
-            a.m_value = get_xml_content(v.child("THE-VALUE"));
-
-        else if(attr_class == "ATTRIBUTE-VALUE-ENUMERATION")
-        {
-            for(auto &e : v.children("VALUES"))
-            {
-                // TODO
-            }
-        }
-        else
-            throw std::runtime_error("Unhandled attribute type: " + attr_class);
-
-        attrs.push_back(a);
+    case reqif::change::added:
+        return "added";
+    case reqif::change::removed:
+        return "removed";
+    case reqif::change::modified:
+        return "modified";
     }
-    return attrs;
+    return "";
 }
 
-file parse(const std::string &filename)
+/// Diff two ReqIF files and write the affected test cases, one per line.
+int run_diff(
+    const std::string &old_filename,
+    const std::string &new_filename,
+    const std::string &selection_filename,
+    const std::string &test_case_type,
+    const std::string &id_attr)
 {
-    pugi::xml_document xml;
-    if(!xml.load_file(filename.c_str()))
-        throw std::runtime_error("Failed to load ReqIF file " + filename);
-
-    auto reqif_node = xml.child("REQ-IF");
-    auto reqif_content_node = reqif_node.child("CORE-CONTENT").child("REQ-IF-CONTENT");
-
-    reqif::file reqif_file;
+    // Parse both files concurrently, for large exports this dominates the run time:
+    auto old_future = std::async(std::launch::async, reqif::parse, old_filename);
+    auto new_file = reqif::parse(new_filename);
+    auto old_file = old_future.get();
+
+    auto d = reqif::compare(old_file, new_file);
+    for(auto &e : d.m_spec_objs)
+        std::cout << "SPEC-OBJECT " << e.m_id << " " << to_string(e.m_change) << "\n";
+    for(auto &e : d.m_spec_relations)
+        std::cout << "SPEC-RELATION " << e.m_id << " " << to_string(e.m_change) << "\n";
+
+    auto selection = reqif::select_test_cases(old_file, new_file, d, test_case_type, id_attr);
+
+    std::ofstream os(selection_filename);
+    if(!os)
+        throw std::runtime_error("Failed to open " + selection_filename);
+    for(auto &name : selection)
+        os << name << "\n";
+
+    std::cout << d.m_spec_objs.size() << " spec object(s) and " << d.m_spec_relations.size()
+              << " spec relation(s) changed, " << selection.size() << " test case(s) selected\n";
+    return 0;
+}
+}
 
-    // Parse the data types:
-    for(auto &d : reqif_content_node.child("DATATYPES").children())
+int main(int argc, char **argv)
+{
+    cxxopts::Options options("reqif_tool", "ReqIF to C++ converter / tool");
+    // clang-format off
+    options.add_options()
+        ("diff-old", "Old ReqIF file to diff against", cxxopts::value<std::string>())
+        ("diff-new", "New ReqIF file", cxxopts::value<std::string>())
+        ("selection", "Output file for the affected test cases",
+            cxxopts::value<std::string>()->default_value("test-selection.txt"))
+        ("test-case-type", "SPEC-OBJECT-TYPE of the test cases",
+            cxxopts::value<std::string>()->default_value("TestCase"))
+        ("test-case-id", "Test case attribute holding the test case name",
+            cxxopts::value<std::string>()->default_value("ID"))
+        ("h,help", "Print usage");
+    // clang-format on
+    auto args = options.parse(argc, argv);
+
+    if(args.count("help"))
     {
-        reqif::data_type dt;
-        dt.m_id = d.attribute("IDENTIFIER").as_string();
-        dt.m_name = d.attribute("LONG-NAME").as_string();
-
-        reqif_file.m_data_types[dt.m_id] = dt;
+        std::cout << options.help() << "\n";
+        return 0;
     }
 
-    // Load the SPEC-TYPES:
-    for(auto &st_node : reqif_content_node.child("SPEC-TYPES").children())
+    if(args.count("diff-old") || args.count("diff-new"))
     {
-        reqif::spec_type st;
-        st.m_id = st_node.attribute("IDENTIFIER").as_string();
-        st.m_name = st_node.attribute("LONG-NAME").as_string();
-
-        // Load the attributes:
-        for(auto &attr : st_node.child("SPEC-ATTRIBUTES").children())
+        if(!args.count("diff-old") || !args.count("diff-new"))
         {
-            reqif::attr_def a;
-            a.m_id = attr.attribute("IDENTIFIER").as_string();
-            a.m_name = attr.attribute("LONG-NAME").as_string();
-            a.m_data_type = attr.child("TYPE").first_child().text().as_string(); // Only one child
-            st.m_attr_defs.push_back(a);
+            std::cerr << "--diff-old and --diff-new must be given together\n"
+                      << options.help() << "\n";
+            return 1;
+        }
+        // E.g. a file which fails to parse, or lacks the test case type / ID attribute:
+        try
+        {
+            return run_diff(
+                args["diff-old"].as<std::string>(),
+                args["diff-new"].as<std::string>(),
+                args["selection"].as<std::string>(),
+                args["test-case-type"].as<std::string>(),
+                args["test-case-id"].as<std::string>());
+        }
+        catch(const std::exception &e)
+        {
+            std::cerr << e.what() << "\n";
+            return 1;
         }
-        reqif_file.m_spec_types[st.m_id] = st;
-    }
-
-    // Load the spec objects:
-    // auto spec_objs_node = reqif_node.hash_value
-    for(auto &o : reqif_content_node.child("SPEC-OBJECTS").children())
-    {
-        reqif::spec_obj so;
-        so.m_id = o.attribute("IDENTIFIER").as_string();
-        so.m_type = o.child("TYPE").child("SPEC-OBJECT-TYPE-REF").text().as_string();
-        so.m_values = parse_attributes(o.child("VALUES"));
-        reqif_file.m_spec_objs[so.m_id] = so;
-    }
-
-    // Load the spec relations:
-    for(auto &r : reqif_content_node.child("SPEC-RELATIONS").children("SPEC-RELATION"))
-    {
-        reqif::spec_relation sr;
-        sr.m_id = r.attribute("IDENTIFIER").as_string();
-        sr.m_target = r.child("TARGET").child("SPEC-OBJECT-REF").text().as_string();
-        sr.m_source = r.child("SOURCE").child("SPEC-OBJECT-REF").text().as_string();
-        reqif_file.m_spec_relations[sr.m_id] = sr;
     }
 
-    // Load the specifications:
-    for(auto &spec_node : reqif_content_node.child("SPECIFICATIONS").children()) { }
-
-    return reqif_file;
-}
-}
-
-int main(int argc, char **argv)
-{
     std::string reqif_filename{"ReqIF/cpp-acceptance-testing.reqif"}; // Input ReqIF file
     std::string cpp_output_filename{"../tests/reqif-spec.cpp"};
     std::string doc_output_filename{"../tests/reqif-doc.html"};
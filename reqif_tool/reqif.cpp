@@ -0,0 +1,141 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include <pugixml.hpp>
+
+#include "reqif.h"
+
+namespace reqif
+{
+namespace
+{
+std::string get_xml_content(const pugi::xml_node &node)
+{
+    std::ostringstream os;
+    for(auto &child : node.children())
+        child.print(os, "", pugi::format_raw);
+    return os.str();
+}
+
+std::vector<attr> parse_attributes(const pugi::xml_node &attr_values_node)
+{
+    std::vector<attr> attrs;
+
+    for(auto &v : attr_values_node.children())
+    {
+        std::string attr_class = v.name();
+
+        reqif::attr a;
+        a.m_defn = v.child("DEFINITION").first_child().text().as_string();
+
+        if(attr_class == "ATTRIBUTE-VALUE-STRING")
+            a.m_value = v.attribute("THE-VALUE").as_string();
+        else if(attr_class == "ATTRIBUTE-VALUE-XHTML")
+            a.m_value = get_xml_content(v.child("THE-VALUE"));
+
+        else if(attr_class == "ATTRIBUTE-VALUE-ENUMERATION")
+        {
+            // Identified by the referenced enum values, e.g. "_vYq1MFTqEfCGts-yRdtXVg":
+            for(auto &e : v.child("VALUES").children("ENUM-VALUE-REF"))
+            {
+                if(!a.m_value.empty())
+                    a.m_value += ',';
+                a.m_value += e.text().as_string();
+            }
+        }
+        else
+            throw std::runtime_error("Unhandled attribute type: " + attr_class);
+
+        attrs.push_back(a);
+    }
+    return attrs;
+}
+}
+
+file parse(const std::string &filename)
+{
+    pugi::xml_document xml;
+    if(!xml.load_file(filename.c_str()))
+        throw std::runtime_error("Failed to load ReqIF file " + filename);
+
+    auto reqif_node = xml.child("REQ-IF");
+    auto reqif_content_node = reqif_node.child("CORE-CONTENT").child("REQ-IF-CONTENT");
+
+    reqif::file reqif_file;
+
+    // Parse the data types:
+    for(auto &d : reqif_content_node.child("DATATYPES").children())
+    {
+        reqif::data_type dt;
+        dt.m_id = d.attribute("IDENTIFIER").as_string();
+        dt.m_name = d.attribute("LONG-NAME").as_string();
+
+        reqif_file.m_data_types[dt.m_id] = dt;
+    }
+
+    // Load the SPEC-TYPES:
+    for(auto &st_node : reqif_content_node.child("SPEC-TYPES").children())
+    {
+        reqif::spec_type st;
+        st.m_id = st_node.attribute("IDENTIFIER").as_string();
+        st.m_name = st_node.attribute("LONG-NAME").as_string();
+
+        // Load the attributes:
+        for(auto &attr : st_node.child("SPEC-ATTRIBUTES").children())
+        {
+            reqif::attr_def a;
+            a.m_id = attr.attribute("IDENTIFIER").as_string();
+            a.m_name = attr.attribute("LONG-NAME").as_string();
+            a.m_data_type = attr.child("TYPE").first_child().text().as_string(); // Only one child
+            st.m_attr_defs.push_back(a);
+        }
+        reqif_file.m_spec_types[st.m_id] = st;
+    }
+
+    // Load the spec objects:
+    // auto spec_objs_node = reqif_node.hash_value
+    for(auto &o : reqif_content_node.child("SPEC-OBJECTS").children())
+    {
+        reqif::spec_obj so;
+        so.m_id = o.attribute("IDENTIFIER").as_string();
+        so.m_type = o.child("TYPE").child("SPEC-OBJECT-TYPE-REF").text().as_string();
+        so.m_values = parse_attributes(o.child("VALUES"));
+        reqif_file.m_spec_objs[so.m_id] = std::move(so);
+    }
+
+    // Load the spec relations:
+    for(auto &r : reqif_content_node.child("SPEC-RELATIONS").children("SPEC-RELATION"))
+    {
+        reqif::spec_relation sr;
+        sr.m_id = r.attribute("IDENTIFIER").as_string();
+        sr.m_target = r.child("TARGET").child("SPEC-OBJECT-REF").text().as_string();
+        sr.m_source = r.child("SOURCE").child("SPEC-OBJECT-REF").text().as_string();
+        sr.m_type = r.child("TYPE").child("SPEC-RELATION-TYPE-REF").text().as_string();
+        sr.m_values = parse_attributes(r.child("VALUES"));
+        reqif_file.m_spec_relations[sr.m_id] = std::move(sr);
+    }
+
+    // Load the specifications:
+    for(auto &spec_node : reqif_content_node.child("SPECIFICATIONS").children()) { }
+
+    return reqif_file;
+}
+}
@@ -0,0 +1,98 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+
+namespace reqif
+{
+class data_type
+{
+public:
+    std::string m_id;
+    std::string m_name;
+};
+
+class attr_def
+{
+public:
+    std::string m_id;
+    std::string m_name;
+    std::string m_data_type;
+};
+
+class spec_type
+{
+public:
+    std::string m_id;
+    std::string m_name;
+    std::vector<attr_def> m_attr_defs;
+};
+
+class attr
+{
+public:
+    std::string m_defn;  //!< Reference to the attribute definition
+    std::string m_value; //!< Attribute contents
+};
+
+class spec_obj
+{
+public:
+    std::string m_id;
+    std::string m_type;
+    std::vector<attr> m_values;
+};
+
+class spec_relation
+{
+public:
+    std::string m_id;
+    std::string m_source;
+    std::string m_target;
+    std::string m_type;
+    std::vector<attr> m_values;
+};
+
+class spec_entry
+{
+public:
+    std::string m_spec_obj;
+    std::vector<spec_entry> m_children;
+};
+
+class specification
+{
+    std::string m_id;
+    std::string m_name;
+    std::vector<spec_entry> m_children;
+};
+
+class file
+{
+public:
+    std::map<std::string, data_type> m_data_types;
+    std::map<std::string, spec_type> m_spec_types;
+    std::map<std::string, spec_relation> m_spec_relations;
+    std::map<std::string, spec_obj> m_spec_objs;
+};
+
+/// Load a ReqIF file (.reqif) into the model.
+file parse(const std::string &filename);
+}
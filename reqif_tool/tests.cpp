@@ -0,0 +1,191 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "cat/cat.h"
+#include "cat/console_reporter.h"
+
+#include "diff.h"
+#include "reqif.h"
+
+namespace
+{
+// Spec objects and relations of ReqIF/cpp-acceptance-testing.reqif used below:
+const std::string sr_tc_macro = "_BXfcIFdlEfC-n4hkpl4_UQ";      // SR-TC-Macro
+const std::string tc_assisted_mode = "_7UDsgFeEEfCCi76yo97ltw"; // TC-AssistedMode
+const std::string tr_asserts = "_QIYCQFeAEfCCi76yo97ltw";       // TR-Asserts
+const std::string tr_test_mode = "_L4UxEFd6EfCCi76yo97ltw";     // TR-TestMode
+const std::string tests_type = "_xWKnYFeBEfCCi76yo97ltw";       // Tests
+const std::string assisted_mode_tests_test_mode = "_MCSkYFeFEfCCi76yo97ltw";
+const std::string basic_usage_tests_asserts = "_N-6CEFeFEfCCi76yo97ltw";
+
+reqif::file parse_original()
+{
+    return reqif::parse(
+        std::string(REQIF_TOOL_SOURCE_DIR) + "/../ReqIF/cpp-acceptance-testing.reqif");
+}
+
+std::vector<std::string> select(const reqif::file &old_file, const reqif::file &new_file)
+{
+    auto d = reqif::compare(old_file, new_file);
+    return reqif::select_test_cases(old_file, new_file, d, "TestCase", "ID");
+}
+
+/// Exit status: the number of failed test cases.
+struct failure_counter : public cat::reporter
+{
+    void on_test_finished(const cat::test_case &tc) override { m_failed += !tc.get_result(); }
+
+    int m_failed{0};
+};
+}
+
+int main()
+{
+    cat::console_reporter c;
+    failure_counter f;
+    cat::register_reporter(&c);
+    cat::register_reporter(&f);
+
+    cat::test_runner runner;
+    runner.run(cat::registry::get_instance().get_test_series_all());
+    return f.m_failed;
+}
+
+TEST_CASE(DiffUnchanged)
+{
+    auto original = parse_original();
+    test(CAT_ASSERT(reqif::compare(original, original).m_spec_objs.size() == 0U));
+    test(CAT_ASSERT(select(original, original).size() == 0U));
+}
+
+TEST_CASE(DiffRequirementEdited)
+{
+    // SR-TC-Macro <- Verifies - TR-TestCase <- Tests - TC-BasicUsage
+    auto original = parse_original();
+    auto edited = original;
+    auto &values = edited.m_spec_objs.at(sr_tc_macro).m_values;
+    auto is_text = [](const reqif::attr &a)
+    { return a.m_value.find("test case macro") != std::string::npos; };
+    auto text = std::find_if(values.begin(), values.end(), is_text);
+    if(!test(CAT_ASSERT(text != values.end())))
+        return;
+    text->m_value += " of at most three lines";
+
+    auto d = reqif::compare(original, edited);
+    test(CAT_ASSERT(d.m_spec_objs.size() == 1U));
+    test(CAT_ASSERT(d.m_spec_objs.at(0).m_id == sr_tc_macro));
+    test(CAT_ASSERT(d.m_spec_objs.at(0).m_change == reqif::change::modified));
+    test(CAT_ASSERT(d.m_spec_relations.size() == 0U));
+    test(CAT_ASSERT(select(original, edited) == std::vector<std::string>{"TC_BasicUsage"}));
+}
+
+TEST_CASE(DiffAttributesReordered)
+{
+    // Only the order of the attribute values of SR-TC-Macro differs, which is not a change:
+    auto original = parse_original();
+    auto reordered = original;
+    auto &values = reordered.m_spec_objs.at(sr_tc_macro).m_values;
+    test(CAT_ASSERT(values.size() >= 2U));
+    std::reverse(values.begin(), values.end());
+
+    test(CAT_ASSERT(reqif::compare(original, reordered).m_spec_objs.size() == 0U));
+    test(CAT_ASSERT(select(original, reordered).size() == 0U));
+}
+
+TEST_CASE(DiffRelationAdded)
+{
+    auto original = parse_original();
+    auto changed = original;
+    changed.m_spec_relations["_added"] =
+        reqif::spec_relation{"_added", tc_assisted_mode, tr_asserts, tests_type, {}};
+
+    auto d = reqif::compare(original, changed);
+    test(CAT_ASSERT(d.m_spec_relations.size() == 1U));
+    test(CAT_ASSERT(d.m_spec_relations.at(0).m_change == reqif::change::added));
+    test(CAT_ASSERT(select(original, changed) == std::vector<std::string>{"TC_AssistedMode"}));
+}
+
+TEST_CASE(DiffRelationRemoved)
+{
+    auto original = parse_original();
+    auto changed = original;
+    changed.m_spec_relations.erase(assisted_mode_tests_test_mode);
+
+    auto d = reqif::compare(original, changed);
+    test(CAT_ASSERT(d.m_spec_relations.size() == 1U));
+    test(CAT_ASSERT(d.m_spec_relations.at(0).m_change == reqif::change::removed));
+    test(CAT_ASSERT(select(original, changed) == std::vector<std::string>{"TC_AssistedMode"}));
+}
+
+TEST_CASE(DiffRelationModified)
+{
+    auto original = parse_original();
+    auto changed = original;
+    changed.m_spec_relations.at(basic_usage_tests_asserts).m_target = tr_test_mode;
+
+    auto d = reqif::compare(original, changed);
+    test(CAT_ASSERT(d.m_spec_relations.size() == 1U));
+    test(CAT_ASSERT(d.m_spec_relations.at(0).m_change == reqif::change::modified));
+    test(CAT_ASSERT(select(original, changed) == std::vector<std::string>{"TC_BasicUsage"}));
+}
+
+TEST_CASE(TC_BasicUsage)
+{
+    // Stands in for the implementation of TC-BasicUsage, which DiffSelectionLoads selects:
+    test(CAT_ASSERT(name() == "TC_BasicUsage"));
+}
+
+TEST_CASE(DiffSelectionLoads)
+{
+    // The selection written by reqif_tool loads the TEST_CASEs implementing the selected ReqIF
+    // test cases, and keeps those which are not implemented so that they are reported as failed.
+    auto original = parse_original();
+    auto changed = original;
+    changed.m_spec_relations.at(basic_usage_tests_asserts).m_target = tr_test_mode;
+    auto selection = select(original, changed);
+
+    const auto filename = std::filesystem::temp_directory_path() /
+        ("cat_test_selection_" + std::to_string(std::random_device{}()) + ".txt");
+    {
+        std::ofstream os(filename);
+        for(auto &name : selection)
+            os << name << "\n";
+        os << "TC-NotImplemented\n";
+    }
+    auto ts = cat::load_test_series(filename.string());
+    std::filesystem::remove(filename);
+
+    const std::vector<std::string> expected{"TC_BasicUsage", "TC_NotImplemented"};
+    test(CAT_ASSERT(ts.get_tests() == expected));
+    test(CAT_ASSERT(cat::registry::get_instance().load_test_case("TC_BasicUsage")->name() ==
+        "TC_BasicUsage"));
+}
+
+TEST_CASE(TestCaseName)
+{
+    test(CAT_ASSERT(cat::test_case_name("TC-BasicUsage") == "TC_BasicUsage"));
+    test(CAT_ASSERT(cat::test_case_name("TC_BasicUsage") == "TC_BasicUsage"));
+    test(CAT_ASSERT(cat::test_case_name("TC 1.2") == "TC_1_2"));
+    test(CAT_ASSERT(cat::test_case_name("1-Smoke") == "_1_Smoke"));
+}
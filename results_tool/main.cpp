@@ -0,0 +1,207 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cxxopts.hpp>
+#include <fmt/chrono.h>
+#include <fmt/format.h>
+
+#include "cat/results_store.h"
+
+namespace
+{
+std::string format_time(std::int64_t ns)
+{
+    const std::chrono::sys_time<std::chrono::nanoseconds> t{std::chrono::nanoseconds(ns)};
+    return fmt::format("{:%Y-%m-%d %H:%M:%S}", std::chrono::floor<std::chrono::seconds>(t));
+}
+
+/// Parse a UTC time as printed by format_time, or a date alone for the start of that day.
+std::int64_t parse_time(const std::string &s)
+{
+    int y = 0, h = 0, min = 0, sec = 0;
+    unsigned m = 0U, d = 0U;
+    char sep = ' ';
+    int consumed = 0;
+    const int fields = std::sscanf(
+        s.c_str(), "%d-%u-%u%c%d:%d:%d%n", &y, &m, &d, &sep, &h, &min, &sec, &consumed);
+    const bool is_time = fields == 7 && (sep == ' ' || sep == 'T') && h >= 0 && h < 24 &&
+                         min >= 0 && min < 60 && sec >= 0 && sec < 60;
+    if(!is_time)
+    {
+        h = min = sec = 0;
+        std::sscanf(s.c_str(), "%d-%u-%u%n", &y, &m, &d, &consumed);
+    }
+
+    const std::chrono::year_month_day date{
+        std::chrono::year(y), std::chrono::month(m), std::chrono::day(d)};
+    if(static_cast<std::size_t>(consumed) != s.size() || !date.ok())
+        throw std::runtime_error(
+            "Invalid time " + s + ", expected e.g. 2025-07-01 or \"2025-07-01 12:00:00\"");
+
+    const auto t = std::chrono::sys_days(date) + std::chrono::hours(h) +
+                   std::chrono::minutes(min) + std::chrono::seconds(sec);
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+cat::results_query make_query(const cxxopts::ParseResult &args)
+{
+    cat::results_query q;
+    if(args.count("test-case"))
+        q.m_test_case = args["test-case"].as<std::string>();
+    if(args.count("site"))
+        q.m_site = args["site"].as<std::string>();
+    if(args.count("serial"))
+        q.m_serial = args["serial"].as<std::string>();
+    if(args.count("from"))
+        q.m_from = parse_time(args["from"].as<std::string>());
+    if(args.count("to"))
+        q.m_to = parse_time(args["to"].as<std::string>());
+    return q;
+}
+}
+
+int main(int argc, char **argv)
+{
+    cxxopts::Options options("results_tool", "Query the historical test results store");
+    // clang-format off
+    options.add_options()
+        ("command", "sites | trend | margins | spc | compact", cxxopts::value<std::string>())
+        ("store", "Results store directory", cxxopts::value<std::string>())
+        ("test-case", "Test case name", cxxopts::value<std::string>())
+        ("site", "Assertion site, e.g. main.cpp:42", cxxopts::value<std::string>())
+        ("serial", "Unit serial number", cxxopts::value<std::string>())
+        ("from", "Only results at or after this UTC time, e.g. \"2025-07-01 10:30:00\"",
+            cxxopts::value<std::string>())
+        ("to", "Only results at or before this UTC time", cxxopts::value<std::string>())
+        ("bins", "Number of margin histogram bins",
+            cxxopts::value<std::size_t>()->default_value("10"))
+        ("baseline", "Number of points to estimate the control limits from (0 = all)",
+            cxxopts::value<std::size_t>()->default_value("0"))
+        ("h,help", "Print usage");
+    // clang-format on
+    options.parse_positional({"command", "store"});
+    options.positional_help("<command> <store>");
+    auto args = options.parse(argc, argv);
+
+    if(args.count("help") || !args.count("command") || !args.count("store"))
+    {
+        std::cout << options.help() << "\n";
+        return args.count("help") ? 0 : 1;
+    }
+
+    const auto command = args["command"].as<std::string>();
+    if(command == "spc" && (!args.count("test-case") || !args.count("site")))
+    {
+        // A control chart of several assertion sites mixes unrelated measurements:
+        std::cerr << "spc requires --test-case and --site\n";
+        return 1;
+    }
+
+    const auto dir = args["store"].as<std::string>();
+    if(!std::filesystem::is_directory(dir))
+    {
+        std::cerr << "No results store at " << dir << "\n";
+        return 1;
+    }
+
+    try
+    {
+        // Only compact writes; while a test run holds the store open for writing it fails.
+        cat::results_store store(
+            dir,
+            command == "compact" ? cat::results_store::mode::write
+                                 : cat::results_store::mode::read);
+
+        if(command == "sites")
+        {
+            for(auto &[test_case, site] : store.sites())
+                fmt::print("{} {}\n", store.lookup(test_case), store.lookup(site));
+        }
+        else if(command == "trend")
+        {
+            for(auto &r : store.query(make_query(args)))
+            {
+                fmt::print(
+                    "{} {} {} {} {} {}\n",
+                    format_time(r.m_time),
+                    store.lookup(r.m_serial),
+                    store.lookup(r.m_site),
+                    r.m_value,
+                    r.m_limit,
+                    r.m_result ? "pass" : "fail");
+            }
+        }
+        else if(command == "margins")
+        {
+            auto h = cat::margin_distribution(
+                store.query(make_query(args)), args["bins"].as<std::size_t>());
+            const double width =
+                h.m_counts.empty() ? 0.0 : (h.m_max - h.m_min) / h.m_counts.size();
+            for(std::size_t u = 0U; u != h.m_counts.size(); ++u)
+            {
+                fmt::print(
+                    "[{:g}, {:g}) {}\n",
+                    h.m_min + u * width,
+                    h.m_min + (u + 1) * width,
+                    h.m_counts[u]);
+            }
+        }
+        else if(command == "spc")
+        {
+            auto rows = store.query(make_query(args));
+            auto s = cat::spc(rows, args["baseline"].as<std::size_t>());
+            fmt::print(
+                "mean {:g} sigma {:g} LCL {:g} UCL {:g}\n", s.m_mean, s.m_sigma, s.m_lcl, s.m_ucl);
+            for(auto &v : s.m_violations)
+            {
+                auto &r = rows.at(v.m_index);
+                fmt::print(
+                    "rule {} {} {} {} {:g}\n",
+                    v.m_rule,
+                    format_time(r.m_time),
+                    store.lookup(r.m_serial),
+                    store.lookup(r.m_site),
+                    r.m_value);
+            }
+        }
+        else if(command == "compact")
+        {
+            store.compact();
+            fmt::print("{} block(s)\n", store.block_count());
+        }
+        else
+        {
+            std::cerr << "Unknown command " << command << "\n" << options.help() << "\n";
+            return 1;
+        }
+    }
+    catch(const std::exception &e)
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
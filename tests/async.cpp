@@ -0,0 +1,287 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "cat/cat.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+// Test cases run by the test_runner under test. They are registered on first use rather than
+// with TEST_CASE, so that they are not part of the series of this executable.
+
+/// Waits 100 ms without holding a thread.
+struct sleeping_test_case final : public cat::async_test_case
+{
+    explicit sleeping_test_case(std::string name) : m_name(std::move(name)) { }
+
+    std::string name() const override { return m_name; }
+    cat::task run_async() override
+    {
+        const auto start = std::chrono::steady_clock::now();
+        co_await cat::delay(100ms);
+        const auto slept_ms = (std::chrono::steady_clock::now() - start) / 1ms;
+        test(CAT_ASSERT(slept_ms >= 100));
+    }
+
+    std::string m_name;
+};
+
+/// Blocks for 20 ms, counting how many blocking test cases run at the same time.
+struct blocking_test_case final : public cat::test_case
+{
+    explicit blocking_test_case(std::string name) : m_name(std::move(name)) { }
+
+    std::string name() const override { return m_name; }
+    void run() override
+    {
+        const int running = ++s_running;
+        int max = s_max_running.load();
+        while(running > max && !s_max_running.compare_exchange_weak(max, running))
+        {
+        }
+        std::this_thread::sleep_for(20ms);
+        --s_running;
+        test(CAT_ASSERT(running >= 1));
+    }
+
+    std::string m_name;
+    static inline std::atomic<int> s_running{0};
+    static inline std::atomic<int> s_max_running{0};
+};
+
+struct throwing_test_case final : public cat::test_case
+{
+    std::string name() const override { return "Fixture.Throws"; }
+    void run() override { throw std::runtime_error("Instrument timeout"); }
+};
+
+struct async_throwing_test_case final : public cat::async_test_case
+{
+    std::string name() const override { return "Fixture.AsyncThrows"; }
+    cat::task run_async() override
+    {
+        co_await cat::delay(10ms);
+        throw std::runtime_error("Instrument disconnected");
+    }
+};
+
+struct passing_test_case final : public cat::test_case
+{
+    std::string name() const override { return "Fixture.Pass"; }
+    void run() override { test(CAT_ASSERT(1 + 1 == 2)); }
+};
+
+std::string sleeper_name(int i) { return "Fixture.Sleep" + std::to_string(i); }
+std::string blocker_name(int i) { return "Fixture.Block" + std::to_string(i); }
+
+void register_fixtures()
+{
+    static const bool registered = []
+    {
+        auto &r = cat::registry::get_instance();
+        for(int i = 0; i < 10; ++i)
+        {
+            auto name = sleeper_name(i);
+            r.register_test_case(
+                name, [name] { return std::make_unique<sleeping_test_case>(name); });
+        }
+        for(int i = 0; i < 4; ++i)
+        {
+            auto name = blocker_name(i);
+            r.register_test_case(
+                name, [name] { return std::make_unique<blocking_test_case>(name); });
+        }
+        r.register_test_case(
+            "Fixture.Throws", [] { return std::make_unique<throwing_test_case>(); });
+        r.register_test_case(
+            "Fixture.AsyncThrows", [] { return std::make_unique<async_throwing_test_case>(); });
+        r.register_test_case("Fixture.Pass", [] { return std::make_unique<passing_test_case>(); });
+        return true;
+    }();
+    (void)registered;
+}
+
+/// Records what the test_runner under test reports.
+struct recorder : public cat::reporter
+{
+    void on_assert(const cat::test_case &tc, const cat::assertion &a) override
+    {
+        m_failures[tc.name()] += a.get_result() ? "" : a.m_expr;
+    }
+    void on_test_starting(const cat::test_case &) override { ++m_started; }
+    void on_test_finished(const cat::test_case &tc) override
+    {
+        m_results[tc.name()] = tc.get_result();
+    }
+    void on_test_series_end(const cat::test_series &) override { ++m_series_ended; }
+
+    int m_started{0};
+    int m_series_ended{0};
+    std::map<std::string, bool> m_results;
+    std::map<std::string, std::string> m_failures; //!< Failed assertions per test case
+};
+
+/// Run the series with only r registered, so that the failures it provokes on purpose are not
+/// counted as failures of this executable. Returns the duration of the run.
+std::chrono::milliseconds run_series(
+    std::vector<std::string> names, std::size_t threads, recorder &r)
+{
+    register_fixtures();
+
+    auto saved = std::exchange(cat::get_reporters(), {&r});
+    const auto start = std::chrono::steady_clock::now();
+    cat::test_runner(threads).run(cat::test_series("fixtures", names));
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    cat::get_reporters() = std::move(saved);
+
+    return std::chrono::duration_cast<std::chrono::milliseconds>(elapsed);
+}
+
+std::vector<std::string> sleepers()
+{
+    std::vector<std::string> names;
+    for(int i = 0; i < 10; ++i)
+        names.push_back(sleeper_name(i));
+    return names;
+}
+
+std::size_t passed(const recorder &r)
+{
+    return std::count_if(r.m_results.begin(), r.m_results.end(), [](auto &x) { return x.second; });
+}
+
+/// Offload a 20 ms blocking call, recording the thread it ran on.
+cat::task offload_sleep(std::set<std::thread::id> &threads, std::mutex &mutex)
+{
+    co_await cat::offload(
+        [&]
+        {
+            std::this_thread::sleep_for(20ms);
+            std::lock_guard lock(mutex);
+            threads.insert(std::this_thread::get_id());
+        });
+}
+}
+
+TEST_CASE(AsyncInterleavedOneThread)
+{
+    // Ten 100 ms delays take about 100 ms in total, not 1 s, when interleaved:
+    recorder r;
+    const auto elapsed_ms = run_series(sleepers(), 1U, r).count();
+    test(CAT_ASSERT(elapsed_ms < 500));
+    test(CAT_ASSERT(passed(r) == 10U));
+    test(CAT_ASSERT(r.m_series_ended == 1));
+}
+
+TEST_CASE(AsyncInterleavedFourThreads)
+{
+    recorder r;
+    const auto elapsed_ms = run_series(sleepers(), 4U, r).count();
+    test(CAT_ASSERT(elapsed_ms < 500));
+    test(CAT_ASSERT(passed(r) == 10U));
+    test(CAT_ASSERT(r.m_series_ended == 1));
+}
+
+TEST_CASE(AsyncBlockingSerialised)
+{
+    // Blocking test cases never overlap, but the async ones still interleave with them:
+    auto names = sleepers();
+    for(int i = 0; i < 4; ++i)
+        names.push_back(blocker_name(i));
+
+    blocking_test_case::s_max_running = 0;
+    recorder r;
+    const auto elapsed_ms = run_series(names, 4U, r).count();
+    const int max_running = blocking_test_case::s_max_running;
+    test(CAT_ASSERT(max_running == 1));
+    test(CAT_ASSERT(elapsed_ms < 500));
+    test(CAT_ASSERT(passed(r) == 14U));
+}
+
+TEST_CASE(AsyncFailuresReported)
+{
+    // Unregistered and throwing test cases fail, and the rest of the series still runs:
+    recorder r;
+    run_series({"Fixture.Missing", "Fixture.Throws", "Fixture.AsyncThrows", "Fixture.Pass"}, 2U, r);
+    test(CAT_ASSERT(r.m_started == 4));
+    test(CAT_ASSERT(r.m_results.size() == 4U));
+    test(CAT_ASSERT(r.m_results["Fixture.Pass"] == true));
+    test(CAT_ASSERT(r.m_results["Fixture.Missing"] == false));
+    test(CAT_ASSERT(r.m_results["Fixture.Throws"] == false));
+    test(CAT_ASSERT(r.m_results["Fixture.AsyncThrows"] == false));
+    test(CAT_ASSERT(r.m_series_ended == 1));
+
+    // The exceptions are reported as failed assertions:
+    const std::string not_registered = "Test case not registered: Fixture.Missing";
+    test(CAT_ASSERT(r.m_failures["Fixture.Missing"] == not_registered));
+    test(CAT_ASSERT(r.m_failures["Fixture.Throws"] == "Instrument timeout"));
+    test(CAT_ASSERT(r.m_failures["Fixture.AsyncThrows"] == "Instrument disconnected"));
+}
+
+TEST_CASE(AsyncOffloadBounded)
+{
+    std::set<std::thread::id> threads;
+    std::mutex mutex;
+    {
+        cat::scheduler s(2U);
+        for(int i = 0; i < 8; ++i)
+            s.spawn(offload_sleep(threads, mutex));
+        s.run();
+    }
+    test(CAT_ASSERT(threads.size() <= 2U));
+    test(CAT_ASSERT(threads.count(std::this_thread::get_id()) == 0U));
+}
+
+ASYNC_TEST_CASE(AsyncOffload)
+{
+    // The calls are named, as gcc 12 destroys a capturing lambda temporary in a co_await
+    // expression twice.
+    auto read = [r = std::make_unique<double>(94.5)] { return *r; }; // Move-only
+    const double dbspl = co_await cat::offload(std::move(read));
+    test(CAT_ASSERT(dbspl == 94.5));
+
+    // completion<void> only signals:
+    cat::completion<void> relay_switched;
+    auto switch_relay = [relay_switched]() mutable { relay_switched.set_value(); };
+    co_await cat::offload(std::move(switch_relay));
+    co_await relay_switched;
+
+    bool rethrown = false;
+    try
+    {
+        co_await cat::offload([] { throw std::runtime_error("No reply"); });
+    }
+    catch(const std::runtime_error &)
+    {
+        rethrown = true;
+    }
+    test(CAT_ASSERT(rethrown == true));
+}
@@ -15,6 +15,8 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  *****************************************************************************/
+#include <chrono>
+
 #include <fmt/color.h>
 #include <fmt/format.h>
 
@@ -36,7 +38,7 @@ public:
     }
 };
 
-int main()
+int main(int argc, char **argv)
 {
     my_reporter r;
     cat::console_reporter c;
@@ -44,7 +46,11 @@ int main()
     cat::register_reporter(&c);
 
     cat::test_runner runner;
-    runner.run(cat::registry::get_instance().get_test_series_all());
+    // Optionally run only a selection, e.g. the test cases affected by a requirements change:
+    if(argc > 1)
+        runner.run(cat::load_test_series(argv[1]));
+    else
+        runner.run(cat::registry::get_instance().get_test_series_all());
 
     return 0;
 }
@@ -70,3 +76,26 @@ TEST_CASE(TestCaseFail)
     test(CAT_ASSERT(2 > 3));
     test(CAT_ASSERT(true && false));
 }
+
+ASYNC_TEST_CASE(TestCaseAsync)
+{
+    using namespace std::chrono_literals;
+
+    // Simulate an instrument which delivers its reading from a driver thread:
+    cat::completion<double> reading;
+    std::thread driver(
+        [reading]() mutable
+        {
+            std::this_thread::sleep_for(20ms);
+            reading.set_value(94.7);
+        });
+
+    co_await cat::delay(10ms);
+    const double dbspl = co_await reading;
+    driver.join();
+    test(CAT_ASSERT(dbspl >= 80.0));
+    test(CAT_ASSERT(dbspl <= 100.0));
+
+    const int settled = co_await cat::offload([] { return 42; });
+    test(CAT_ASSERT(settled == 42));
+}
@@ -0,0 +1,362 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "cat/cat.h"
+#include "cat/results_store.h"
+
+namespace
+{
+using mode = cat::results_store::mode;
+
+constexpr double nan = std::numeric_limits<double>::quiet_NaN();
+
+/// The path of a results store which does not exist yet, in a directory of its own (so that
+/// test runs in parallel do not share a store) which is removed afterwards.
+struct temp_store_dir
+{
+    explicit temp_store_dir(const std::string &name)
+    {
+        std::random_device rd;
+        do
+            m_root = std::filesystem::temp_directory_path() /
+                ("cat_results_store_" + name + "_" + std::to_string(rd()));
+        while(!std::filesystem::create_directory(m_root));
+        m_path = m_root / "store";
+    }
+    ~temp_store_dir()
+    {
+        std::error_code ec;
+        std::filesystem::remove_all(m_root, ec);
+    }
+
+    std::filesystem::path m_root;
+    std::filesystem::path m_path;
+};
+
+cat::result_record record(
+    std::int64_t time, const char *test_case, const char *site, const char *serial, double value)
+{
+    return cat::result_record{
+        time, test_case, site, serial, cat::op::le, value <= 100.0, value, 100.0};
+}
+
+cat::results_query query(const char *test_case, const char *site)
+{
+    cat::results_query q;
+    q.m_test_case = test_case;
+    q.m_site = site;
+    return q;
+}
+
+bool same_rows(const std::vector<cat::result_row> &a, const std::vector<cat::result_row> &b)
+{
+    auto key = [](const cat::result_row &r)
+    { return std::tie(r.m_time, r.m_test_case, r.m_site, r.m_serial, r.m_value, r.m_limit); };
+    return std::equal(
+        a.begin(), a.end(), b.begin(), b.end(), [&](auto &x, auto &y) { return key(x) == key(y); });
+}
+
+void append_bytes(const std::filesystem::path &p, std::size_t n)
+{
+    std::ofstream os(p, std::ios::binary | std::ios::app);
+    os << std::string(n, '\x7f');
+}
+
+std::vector<cat::result_row> to_rows(const std::vector<double> &values)
+{
+    std::vector<cat::result_row> rows;
+    for(auto v : values)
+        rows.push_back(cat::result_row{
+            static_cast<std::int64_t>(rows.size()), 0U, 0U, 0U, cat::op::le, true, v, 100.0});
+    return rows;
+}
+
+/// Twenty points alternating 11, 9: mean 10 and no flags.
+std::vector<double> in_control()
+{
+    std::vector<double> values;
+    for(int u = 0; u != 10; ++u)
+        values.insert(values.end(), {11.0, 9.0});
+    return values;
+}
+
+std::vector<std::size_t> flagged(const cat::spc_result &s, int rule)
+{
+    std::vector<std::size_t> indexes;
+    for(auto &v : s.m_violations)
+        if(v.m_rule == rule)
+            indexes.push_back(v.m_index);
+    return indexes;
+}
+}
+
+TEST_CASE(ResultsStoreAppendQuery)
+{
+    temp_store_dir dir("append_query");
+    {
+        cat::results_store store(dir.m_path, mode::write);
+        store.append(
+            {record(3, "A", "a.cpp:1", "SN1", 3.0),
+             record(1, "A", "a.cpp:1", "SN2", 1.0),
+             record(2, "B", "b.cpp:2", "SN1", 2.0)});
+        store.append({record(4, "A", "a.cpp:2", "SN1", 4.0)});
+    }
+
+    cat::results_store store(dir.m_path);
+    auto rows = store.query(query("A", "a.cpp:1"));
+    test(CAT_ASSERT(rows.size() == 2U));
+    test(CAT_ASSERT(rows.at(0).m_time == 1));
+    test(CAT_ASSERT(store.lookup(rows.at(0).m_serial) == "SN2"));
+    test(CAT_ASSERT(rows.at(1).m_value == 3.0));
+
+    cat::results_query by_serial;
+    by_serial.m_serial = "SN1";
+    test(CAT_ASSERT(store.query(by_serial).size() == 3U));
+
+    cat::results_query by_time;
+    by_time.m_from = 2;
+    by_time.m_to = 3;
+    test(CAT_ASSERT(store.query(by_time).size() == 2U));
+
+    test(CAT_ASSERT(store.query(query("C", "a.cpp:1")).size() == 0U));
+    test(CAT_ASSERT(store.sites().size() == 3U));
+}
+
+TEST_CASE(ResultsStoreCompact)
+{
+    temp_store_dir dir("compact");
+    cat::results_store store(dir.m_path, mode::write);
+    for(std::int64_t t = 0; t != 30; t += 3)
+    {
+        store.append(
+            {record(t, "A", "a.cpp:1", "SN1", 1.0 * t),
+             record(t + 1, "B", "b.cpp:1", "SN1", 2.0 * t),
+             record(t + 2, "A", "a.cpp:2", "SN2", 3.0 * t)});
+    }
+    const auto before = store.query({});
+    cat::results_store reader(dir.m_path);
+
+    store.compact(4U);
+    test(CAT_ASSERT(same_rows(store.query({}), before) == true));
+    test(CAT_ASSERT(store.query(query("A", "a.cpp:1")).size() == 10U));
+    test(CAT_ASSERT(store.block_count() == 8U)); // 30 rows in blocks of up to 4
+    test(CAT_ASSERT(same_rows(reader.query({}), before) == true));
+
+    // The second compaction only sorts the rows appended since the first, into a new tier:
+    const auto tier_size = std::filesystem::file_size(dir.m_path / "tier-0.blocks.bin");
+    store.append({record(30, "A", "a.cpp:1", "SN3", 30.0)});
+    auto all = store.query({});
+    store.compact(4U);
+    test(CAT_ASSERT(std::filesystem::file_size(dir.m_path / "tier-0.blocks.bin") == tier_size));
+    test(CAT_ASSERT(std::filesystem::exists(dir.m_path / "tier-1.blocks.bin") == true));
+    test(CAT_ASSERT(same_rows(store.query({}), all) == true));
+    test(CAT_ASSERT(same_rows(cat::results_store(dir.m_path).query({}), all) == true));
+}
+
+TEST_CASE(ResultsStoreTierMerge)
+{
+    // A tier no larger than merge_factor times the rows newer than it is merged into the new tier:
+    temp_store_dir dir("tier_merge");
+    cat::results_store store(dir.m_path, mode::write);
+    store.append({record(0, "A", "a.cpp:1", "SN1", 0.0), record(1, "B", "b.cpp:1", "SN1", 1.0)});
+    store.compact(4U);
+    store.append({record(2, "A", "a.cpp:1", "SN2", 2.0)});
+    const auto before = store.query({});
+    cat::results_store reader(dir.m_path);
+    store.compact(4U);
+    test(CAT_ASSERT(store.tier_count() == 1U));
+    test(CAT_ASSERT(same_rows(store.query({}), before) == true));
+    test(CAT_ASSERT(store.query(query("A", "a.cpp:1")).size() == 2U));
+
+    // The merged tier is kept for the readers opened before, until the next compaction:
+    test(CAT_ASSERT(same_rows(reader.query({}), before) == true));
+    store.append({record(3, "B", "b.cpp:1", "SN2", 3.0)});
+    store.compact(4U);
+    test(CAT_ASSERT(std::filesystem::exists(dir.m_path / "tier-0.blocks.bin") == false));
+
+    // Many small compactions leave few tiers, holding every row:
+    for(std::int64_t t = 4; t != 400; t += 2)
+    {
+        store.append(
+            {record(t, "A", "a.cpp:1", "SN1", 1.0), record(t + 1, "B", "b.cpp:1", "SN1", 2.0)});
+        store.compact(4U);
+        if(store.tier_count() > 4U)
+            break;
+    }
+    test(CAT_ASSERT(store.tier_count() <= 4U));
+    test(CAT_ASSERT(store.query({}).size() == 400U));
+    test(CAT_ASSERT(cat::results_store(dir.m_path).query({}).size() == 400U));
+    test(CAT_ASSERT(store.sites().size() == 2U));
+}
+
+TEST_CASE(ResultsStoreTornWrite)
+{
+    temp_store_dir dir("torn_write");
+    {
+        cat::results_store store(dir.m_path, mode::write);
+        store.append(
+            {record(1, "A", "a.cpp:1", "SN1", 1.0), record(2, "A", "a.cpp:1", "SN2", 2.0)});
+    }
+
+    // A write cut short: part of a block, of its index entry and of a dictionary record.
+    const auto blocks = dir.m_path / "log-0.blocks.bin";
+    const auto index = dir.m_path / "log-0.index.bin";
+    const auto dictionary = dir.m_path / "dictionary.bin";
+    const auto sizes = std::make_tuple(
+        std::filesystem::file_size(blocks),
+        std::filesystem::file_size(index),
+        std::filesystem::file_size(dictionary));
+    append_bytes(blocks, 10U);
+    append_bytes(index, 5U);
+    append_bytes(dictionary, 3U);
+
+    // A reader ignores the torn write and leaves it alone, as a writer may still be writing it:
+    test(CAT_ASSERT(cat::results_store(dir.m_path).query({}).size() == 2U));
+    test(CAT_ASSERT(std::filesystem::file_size(blocks) == std::get<0>(sizes) + 10U));
+
+    // A writer rolls it back:
+    {
+        cat::results_store store(dir.m_path, mode::write);
+        test(CAT_ASSERT(std::filesystem::file_size(blocks) == std::get<0>(sizes)));
+        test(CAT_ASSERT(std::filesystem::file_size(index) == std::get<1>(sizes)));
+        test(CAT_ASSERT(std::filesystem::file_size(dictionary) == std::get<2>(sizes)));
+        store.append({record(3, "A", "a.cpp:1", "SN3", 3.0)});
+    }
+
+    cat::results_store store(dir.m_path);
+    auto rows = store.query({});
+    test(CAT_ASSERT(rows.size() == 3U));
+    test(CAT_ASSERT(store.lookup(rows.at(2).m_serial) == "SN3"));
+}
+
+TEST_CASE(ResultsStoreSingleWriter)
+{
+    temp_store_dir dir("single_writer");
+
+    // A reader needs an existing store, rather than creating an empty one:
+    bool missing = false;
+    try
+    {
+        cat::results_store store(dir.m_path);
+    }
+    catch(const std::runtime_error &)
+    {
+        missing = true;
+    }
+    test(CAT_ASSERT(missing == true));
+    test(CAT_ASSERT(std::filesystem::exists(dir.m_path) == false));
+
+    bool locked = false;
+    {
+        cat::results_store writer(dir.m_path, mode::write);
+        writer.append({record(1, "A", "a.cpp:1", "SN1", 1.0)});
+        try
+        {
+            cat::results_store second(dir.m_path, mode::write);
+        }
+        catch(const std::runtime_error &)
+        {
+            locked = true;
+        }
+        test(CAT_ASSERT(cat::results_store(dir.m_path).query({}).size() == 1U));
+    }
+    test(CAT_ASSERT(locked == true));
+
+    cat::results_store writer(dir.m_path, mode::write); // The lock was released
+    writer.append({record(2, "A", "a.cpp:1", "SN1", 2.0)});
+    test(CAT_ASSERT(writer.query({}).size() == 2U));
+}
+
+TEST_CASE(ResultsStoreReporter)
+{
+    temp_store_dir dir("reporter");
+    cat::results_store store(dir.m_path, mode::write);
+    cat::results_store_reporter reporter(store, "SN1");
+
+    // Persisted when the test case finishes, even if the series never ends:
+    reporter.on_assert(
+        m_test_case,
+        cat::assertion{"v <= 100.0", cat::op::le, true, {}, {}, "main.cpp", 42, 90.0, 100.0});
+    reporter.on_test_finished(m_test_case);
+
+    auto rows = store.query(query("ResultsStoreReporter", "main.cpp:42"));
+    test(CAT_ASSERT(rows.size() == 1U));
+    test(CAT_ASSERT(rows.at(0).m_value == 90.0));
+    test(CAT_ASSERT(store.lookup(rows.at(0).m_serial) == "SN1"));
+}
+
+TEST_CASE(ResultsStoreMargins)
+{
+    auto rows = to_rows({90.0, 95.0, 98.0});
+    rows.push_back(cat::result_row{3, 0U, 0U, 0U, cat::op::ge, true, 12.0, 10.0});
+    rows.push_back(cat::result_row{4, 0U, 0U, 0U, cat::op::eq, true, 1.0, 1.0}); // No margin
+
+    // Margins 10, 5, 2 and 2 in bins [2, 4), [4, 6), [6, 8), [8, 10]:
+    auto h = cat::margin_distribution(rows, 4U);
+    test(CAT_ASSERT(h.m_min == 2.0));
+    test(CAT_ASSERT(h.m_max == 10.0));
+    const std::vector<std::size_t> counts{2U, 1U, 0U, 1U};
+    test(CAT_ASSERT(h.m_counts == counts));
+}
+
+TEST_CASE(ResultsStoreSpc)
+{
+    // 1. A point outside the control limits:
+    auto outlier = in_control();
+    outlier.push_back(20.0);
+    auto s = cat::spc(to_rows(outlier), 20U);
+    test(CAT_ASSERT(s.m_mean == 10.0));
+    test(CAT_ASSERT(flagged(s, 1) == std::vector<std::size_t>{20U}));
+    test(CAT_ASSERT(flagged(s, 2).size() == 0U));
+    test(CAT_ASSERT(flagged(s, 3).size() == 0U));
+
+    // 2. Nine points in a row above the mean:
+    auto shift = in_control();
+    shift.insert(shift.end(), 9U, 10.5);
+    s = cat::spc(to_rows(shift), 20U);
+    test(CAT_ASSERT(flagged(s, 1).size() == 0U));
+    test(CAT_ASSERT(flagged(s, 2) == std::vector<std::size_t>{28U}));
+    test(CAT_ASSERT(flagged(s, 3).size() == 0U));
+
+    // 3. Six points in a row increasing, from the last 9.0 at index 19:
+    auto drift = in_control();
+    drift.insert(drift.end(), {9.2, 9.4, 9.6, 9.8, 9.9});
+    s = cat::spc(to_rows(drift), 20U);
+    test(CAT_ASSERT(flagged(s, 1).size() == 0U));
+    test(CAT_ASSERT(flagged(s, 2).size() == 0U));
+    test(CAT_ASSERT(flagged(s, 3) == std::vector<std::size_t>{24U}));
+
+    // Rows without a measured value are skipped, the flags still index the rows:
+    auto with_nan = outlier;
+    with_nan.insert(with_nan.begin(), nan);
+    with_nan.push_back(nan);
+    s = cat::spc(to_rows(with_nan), 20U);
+    test(CAT_ASSERT(s.m_mean == 10.0));
+    test(CAT_ASSERT(std::isnan(s.m_ucl) == false));
+    test(CAT_ASSERT(flagged(s, 1) == std::vector<std::size_t>{21U}));
+}
@@ -0,0 +1,42 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include "cat/cat.h"
+#include "cat/console_reporter.h"
+
+namespace
+{
+/// Exit status: the number of failed test cases, so that a failing test fails ctest.
+struct failure_counter : public cat::reporter
+{
+    void on_test_finished(const cat::test_case &tc) override { m_failed += !tc.get_result(); }
+
+    int m_failed{0};
+};
+}
+
+int main()
+{
+    cat::console_reporter c;
+    failure_counter f;
+    cat::register_reporter(&c);
+    cat::register_reporter(&f);
+
+    cat::test_runner runner;
+    runner.run(cat::registry::get_instance().get_test_series_all());
+    return f.m_failed;
+}